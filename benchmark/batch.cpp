@@ -0,0 +1,80 @@
+/*
+
+Copyright (c) 2014 Jarryd Beck
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+
+// Parses a batch of recorded command lines with one thread and with one per
+// hardware thread.
+
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+#define CXXOPTS_USE_BULK_PARSING
+#include "cxxopts.hpp"
+
+int
+main()
+{
+  cxxopts::Options options("batch", "batch parse benchmark");
+  options.add_options()
+    ("v,verbose", "verbose output")
+    ("o,output", "output file", cxxopts::value<std::string>())
+    ("j,jobs", "jobs", cxxopts::value<int>()->default_value("1"))
+    ("input", "input files", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional({"input"});
+  const auto compiled = options.compile();
+
+  const char* shapes[][6] = {
+    {"batch", "-v", "--output", "out.txt", "a.c", "b.c"},
+    {"batch", "-j", "8", "--output=build/main.o", "main.c", "util.c"},
+    {"batch", "--jobs=4", "-vo", "x", "one.c", "two.c"},
+  };
+
+  const std::size_t count = 100000;
+  std::vector<cxxopts::CommandLine> lines;
+  for (std::size_t i = 0; i != count; ++i)
+  {
+    lines.push_back({6, shapes[i % 3]});
+  }
+
+  std::vector<unsigned> worker_counts{1};
+  if (std::thread::hardware_concurrency() > 1)
+  {
+    worker_counts.push_back(std::thread::hardware_concurrency());
+  }
+
+  for (unsigned workers : worker_counts)
+  {
+    auto ns = benchmark::time_ns([&] {
+      auto results = compiled.parse_batch(lines, workers);
+      benchmark::keep(results.size());
+    });
+
+    benchmark::report("parse_batch, " + std::to_string(workers) + " threads",
+      ns / static_cast<double>(count), "line");
+  }
+
+  return 0;
+}
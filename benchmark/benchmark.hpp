@@ -0,0 +1,132 @@
+/*
+
+Copyright (c) 2014 Jarryd Beck
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+// Minimal timing helpers shared by the benchmarks. Each benchmark is a
+// single translation unit that includes this header once.
+
+#ifndef CXXOPTS_BENCHMARK_HPP_INCLUDED
+#define CXXOPTS_BENCHMARK_HPP_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// The replacement operator new below is backed by malloc, which GCC reports
+// wherever it can see both an allocation and its release.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace benchmark
+{
+  volatile std::size_t sink = 0;
+
+  // The number of calls to operator new so far. Atomic, since batch
+  // benchmarks allocate on several threads.
+  std::atomic<std::size_t> allocation_count{0};
+
+  // Returns the number of allocations made by one call to `f`.
+  template <typename F>
+  std::size_t
+  allocations(F f)
+  {
+    f();
+
+    const auto before = allocation_count.load(std::memory_order_relaxed);
+    f();
+    return allocation_count.load(std::memory_order_relaxed) - before;
+  }
+
+  // Stops the optimiser from discarding the work that computed `value`.
+  inline
+  void
+  keep(std::size_t value)
+  {
+    sink = sink + value;
+  }
+
+  // Runs `f` repeatedly for at least `min_seconds`, and returns the mean
+  // time for one call in nanoseconds.
+  template <typename F>
+  double
+  time_ns(F f, double min_seconds = 0.2)
+  {
+    using clock = std::chrono::steady_clock;
+
+    f();
+
+    size_t iterations = 1;
+    for (;;)
+    {
+      auto start = clock::now();
+      for (size_t i = 0; i != iterations; ++i)
+      {
+        f();
+      }
+      std::chrono::duration<double> elapsed = clock::now() - start;
+      if (elapsed.count() >= min_seconds)
+      {
+        return elapsed.count() * 1e9 / static_cast<double>(iterations);
+      }
+      iterations *= 2;
+    }
+  }
+
+  inline
+  void
+  report(const std::string& name, double ns, const std::string& unit = "op")
+  {
+    std::printf("%-48s %12.1f ns/%s\n", name.c_str(), ns, unit.c_str());
+  }
+} // namespace benchmark
+
+void*
+operator new(std::size_t size)
+{
+  benchmark::allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+  if (void* p = std::malloc(size == 0 ? 1 : size))
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+#endif // CXXOPTS_BENCHMARK_HPP_INCLUDED
@@ -0,0 +1,93 @@
+/*
+
+Copyright (c) 2014 Jarryd Beck
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+
+// Compares looking up option names in the static OptionIndex against the
+// unordered_map that the parser used to search.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "cxxopts.hpp"
+
+int
+main()
+{
+  for (size_t count : {10, 100, 1000, 10000})
+  {
+    cxxopts::OptionMap map;
+    std::vector<std::string> names;
+    for (size_t i = 0; i != count; ++i)
+    {
+      names.push_back("option-name-" + std::to_string(i));
+      map.emplace(names.back(), std::make_shared<cxxopts::OptionDetails>(
+        "", names.back(), "", cxxopts::value<std::string>(), i));
+    }
+
+    // Look the names up from separate storage, as the parser does with
+    // the tokens in argv, and in an order that defeats the cache.
+    std::vector<std::string> queries;
+    for (size_t i = 0; i != 4096; ++i)
+    {
+      queries.push_back(names[(i * 7919) % count]);
+    }
+    std::shuffle(queries.begin(), queries.end(), std::mt19937(42));
+
+    cxxopts::OptionIndex index(map);
+
+    const auto queries_ns = static_cast<double>(queries.size());
+    auto map_ns = benchmark::time_ns([&] {
+      size_t found = 0;
+      for (const auto& query : queries)
+      {
+        cxxopts::StringView view(query);
+        found += map.find(std::string(view.data(), view.size())) != map.end();
+      }
+      benchmark::keep(found);
+    }) / queries_ns;
+
+    auto index_ns = benchmark::time_ns([&] {
+      size_t found = 0;
+      for (const auto& query : queries)
+      {
+        found += index.find(query) != nullptr;
+      }
+      benchmark::keep(found);
+    }) / queries_ns;
+
+    auto build_ns = benchmark::time_ns([&] {
+      cxxopts::OptionIndex rebuilt(map);
+      benchmark::keep(rebuilt.find(names[0]) != nullptr);
+    });
+
+    const auto suffix = " (" + std::to_string(count) + " options)";
+    benchmark::report("unordered_map::find" + suffix, map_ns, "lookup");
+    benchmark::report("OptionIndex::find" + suffix, index_ns, "lookup");
+    benchmark::report("OptionIndex construction" + suffix, build_ns, "build");
+  }
+
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+
+Copyright (c) 2014 Jarryd Beck
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+
+// Parses a short command line against schemas of increasing size, with
+// dense and sparse results.
+
+#include <vector>
+
+#include "benchmark.hpp"
+#include "cxxopts.hpp"
+
+int
+main()
+{
+  for (size_t count : {10, 100, 1500, 10000})
+  {
+    cxxopts::Options options("parse", "parse benchmark");
+    auto adder = options.add_options();
+    adder("v,verbose", "verbose output");
+    adder("o,output", "output file", cxxopts::value<std::string>());
+    for (size_t i = 0; i != count; ++i)
+    {
+      adder(("option-" + std::to_string(i)).c_str(), "an option",
+        cxxopts::value<int>()->default_value(std::to_string(i)));
+    }
+
+    const char* argv[] = {"parse", "-v", "--output", "file"};
+    const int argc = 4;
+
+    const auto dense = options.compile();
+    options.set_sparse_results();
+    const auto sparse = options.compile();
+
+    auto dense_ns = benchmark::time_ns([&] {
+      auto result = dense.parse(argc, argv);
+      benchmark::keep(result.count("verbose"));
+    });
+
+    auto sparse_ns = benchmark::time_ns([&] {
+      auto result = sparse.parse(argc, argv);
+      benchmark::keep(result.count("verbose"));
+    });
+
+    const auto suffix = " (" + std::to_string(count) + " options)";
+    benchmark::report("dense parse" + suffix, dense_ns, "parse");
+    benchmark::report("sparse parse" + suffix, sparse_ns, "parse");
+  }
+
+  return 0;
+}
@@ -0,0 +1,77 @@
+/*
+
+Copyright (c) 2014 Jarryd Beck
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+
+// Compares parsing short command lines into a new result each time with
+// parsing them into a reused ParseContext, by allocations and by time.
+
+#include <vector>
+
+#include "benchmark.hpp"
+#include "cxxopts.hpp"
+
+int
+main()
+{
+  cxxopts::Options options("reuse", "parse context benchmark");
+  options.add_options()
+    ("v,verbose", "verbose output")
+    ("o,output", "output file", cxxopts::value<std::string>())
+    ("l,level", "level", cxxopts::value<int>()->default_value("1"))
+    ("t,tag", "tags", cxxopts::value<std::vector<std::string>>())
+    ("route", "route", cxxopts::value<std::string>())
+    ;
+  options.parse_positional({"route"});
+
+  const char* first[] = {"reuse", "-v", "--output", "/var/log/router/out.log",
+    "/api/v1/requests/forwarded", "--tag=alpha", "-t", "beta"};
+  const char* second[] = {"reuse", "-l", "3", "/api/v1/health/ready/check",
+    "--tag=a-rather-long-tag-value"};
+  const int first_count = 8;
+  const int second_count = 5;
+
+  const auto compiled = options.compile();
+  auto context = compiled.context();
+
+  auto parse_new = [&] {
+    auto a = compiled.parse(first_count, first);
+    auto b = compiled.parse(second_count, second);
+    benchmark::keep(a.count("verbose") + b.count("level"));
+  };
+  auto parse_reused = [&] {
+    benchmark::keep(context.parse(first_count, first).count("verbose"));
+    benchmark::keep(context.parse(second_count, second).count("level"));
+  };
+
+  std::printf("%-48s %12.1f allocations/parse\n", "new result",
+    static_cast<double>(benchmark::allocations(parse_new)) / 2);
+  std::printf("%-48s %12.1f allocations/parse\n", "reused context",
+    static_cast<double>(benchmark::allocations(parse_reused)) / 2);
+
+  benchmark::report("new result", benchmark::time_ns(parse_new) / 2, "parse");
+  benchmark::report("reused context", benchmark::time_ns(parse_reused) / 2,
+    "parse");
+
+  return 0;
+}
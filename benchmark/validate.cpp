@@ -0,0 +1,75 @@
+/*
+
+Copyright (c) 2014 Jarryd Beck
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+
+// Compares checking a command line with validate against parsing it and
+// throwing the result away.
+
+#include <vector>
+
+#include "benchmark.hpp"
+#include "cxxopts.hpp"
+
+int
+main()
+{
+  cxxopts::Options options("validate", "validate benchmark");
+  options.add_options()
+    ("v,verbose", "verbose output")
+    ("o,output", "output file", cxxopts::value<std::string>())
+    ("j,jobs", "jobs", cxxopts::value<int>()->default_value("1"))
+    ("r,ratio", "ratio", cxxopts::value<double>()->default_value("0.5"))
+    ("d,define", "definitions", cxxopts::value<std::vector<std::string>>())
+    ("input", "input files", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional({"input"});
+  const auto compiled = options.compile();
+
+  const char* argv[] = {"validate", "-v", "--output", "build/output/main.o",
+    "-j", "8", "--ratio=0.75", "-d", "NAME=value", "-dDEBUG",
+    "src/main.cpp", "src/options/parser.cpp", "src/util.cpp"};
+  const int argc = 13;
+
+  auto parse = [&] {
+    auto result = compiled.parse(argc, argv);
+    benchmark::keep(result.count("verbose"));
+  };
+  auto validate = [&] {
+    benchmark::keep(compiled.validate(argc, argv).error() ==
+      cxxopts::ParseError::None);
+  };
+
+  std::printf("%-48s %12zu allocations\n", "parse",
+    benchmark::allocations(parse));
+  std::printf("%-48s %12zu allocations\n", "validate",
+    benchmark::allocations(validate));
+
+  const auto parse_ns = benchmark::time_ns(parse);
+  const auto validate_ns = benchmark::time_ns(validate);
+  benchmark::report("parse", parse_ns);
+  benchmark::report("validate", validate_ns);
+  std::printf("%-48s %12.2fx\n", "validate speedup", parse_ns / validate_ns);
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+/*
+
+Copyright (c) 2014 Jarryd Beck
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+
+// Counts the allocations that a parse makes for each option value, for
+// options given on the command line and for options left at their default.
+
+#include <vector>
+
+#include "benchmark.hpp"
+#include "cxxopts.hpp"
+
+int
+main()
+{
+  const size_t count = 100;
+
+  cxxopts::Options options("values", "value storage benchmark");
+  auto adder = options.add_options();
+
+  std::vector<std::string> arguments{"values"};
+  for (size_t i = 0; i != count; ++i)
+  {
+    const auto name = "option-" + std::to_string(i);
+    switch (i % 4)
+    {
+      case 0:
+        adder(name.c_str(), "an int", cxxopts::value<int>()->default_value("1"));
+        arguments.push_back("--" + name + "=42");
+        break;
+      case 1:
+        adder(name.c_str(), "a double",
+          cxxopts::value<double>()->default_value("0.5"));
+        arguments.push_back("--" + name + "=2.5");
+        break;
+      case 2:
+        adder(name.c_str(), "a bool", cxxopts::value<bool>());
+        arguments.push_back("--" + name);
+        break;
+      default:
+        adder(name.c_str(), "a string",
+          cxxopts::value<std::string>()->default_value("text"));
+        arguments.push_back("--" + name + "=value");
+        break;
+    }
+  }
+
+  std::vector<const char*> given;
+  for (const auto& argument : arguments)
+  {
+    given.push_back(argument.c_str());
+  }
+  const char* none[] = {"values"};
+
+  const auto compiled = options.compile();
+
+  auto parse_given = [&] {
+    auto result = compiled.parse(static_cast<int>(given.size()), given.data());
+    benchmark::keep(result.count("option-0"));
+  };
+  auto parse_defaults = [&] {
+    auto result = compiled.parse(1, none);
+    benchmark::keep(result.count("option-0"));
+  };
+
+  const auto per_option = static_cast<double>(count);
+  std::printf("%-48s %12.2f allocations/option\n", "options given",
+    static_cast<double>(benchmark::allocations(parse_given)) / per_option);
+  std::printf("%-48s %12.2f allocations/option\n", "options defaulted",
+    static_cast<double>(benchmark::allocations(parse_defaults)) / per_option);
+
+  benchmark::report("parse, options given", benchmark::time_ns(parse_given)
+    / per_option, "option");
+  benchmark::report("parse, options defaulted",
+    benchmark::time_ns(parse_defaults) / per_option, "option");
+
+  return 0;
+}
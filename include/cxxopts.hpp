@@ -26,11 +26,13 @@ THE SOFTWARE.
 #define CXXOPTS_HPP_INCLUDED
 
 #include <cctype>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <exception>
 #include <iostream>
+#include <iterator>
 #include <limits>
-#include <list>
 #include <map>
 #include <memory>
 #include <sstream>
@@ -40,22 +42,27 @@ THE SOFTWARE.
 #include <utility>
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
 
-#if defined(__GNUC__) && !defined(__clang__)
-#  if (__GNUC__ * 10 + __GNUC_MINOR__) < 49
-#    define CXXOPTS_NO_REGEX true
-#  endif
+// Batch parsing and corpus analysis are only declared when this is defined,
+// since they need threads and the threads library.
+#ifdef CXXOPTS_USE_BULK_PARSING
+#include <thread>
 #endif
 
-#ifndef CXXOPTS_NO_REGEX
-#  include <regex>
-#endif  // CXXOPTS_NO_REGEX
-
 #ifdef __cpp_lib_optional
 #include <optional>
 #define CXXOPTS_HAS_OPTIONAL
 #endif
 
+#ifdef __cpp_lib_string_view
+#include <string_view>
+#define CXXOPTS_HAS_STRING_VIEW
+#endif
+
 #if __cplusplus >= 201603L
 #define CXXOPTS_NODISCARD [[nodiscard]]
 #else
@@ -310,6 +317,113 @@ namespace cxxopts
 #endif
   } // namespace
 
+  // A non-owning reference to a run of characters, such as a piece of an
+  // element of argv. The referenced characters must outlive the view.
+  class StringView
+  {
+    public:
+    constexpr StringView() noexcept = default;
+
+    constexpr StringView(const char* data, std::size_t size) noexcept
+    : m_data(data)
+    , m_size(size)
+    {
+    }
+
+    StringView(const char* s) noexcept // NOLINT: implicit like std::string
+    : m_data(s)
+    , m_size(std::strlen(s))
+    {
+    }
+
+    StringView(const std::string& s) noexcept // NOLINT
+    : m_data(s.data())
+    , m_size(s.size())
+    {
+    }
+
+#ifdef CXXOPTS_HAS_STRING_VIEW
+    constexpr StringView(std::string_view s) noexcept // NOLINT
+    : m_data(s.data())
+    , m_size(s.size())
+    {
+    }
+#endif
+
+    constexpr const char*
+    data() const noexcept
+    {
+      return m_data;
+    }
+
+    constexpr std::size_t
+    size() const noexcept
+    {
+      return m_size;
+    }
+
+    constexpr bool
+    empty() const noexcept
+    {
+      return m_size == 0;
+    }
+
+    constexpr const char*
+    begin() const noexcept
+    {
+      return m_data;
+    }
+
+    constexpr const char*
+    end() const noexcept
+    {
+      return m_data + m_size;
+    }
+
+    constexpr char
+    operator[](std::size_t i) const noexcept
+    {
+      return m_data[i];
+    }
+
+    StringView
+    substr(std::size_t pos) const noexcept
+    {
+      return StringView(m_data + pos, m_size - pos);
+    }
+
+    CXXOPTS_NODISCARD
+    std::string
+    str() const
+    {
+      return std::string(m_data, m_size);
+    }
+
+    private:
+    const char* m_data = "";
+    std::size_t m_size = 0;
+  };
+
+  inline
+  bool
+  operator==(StringView lhs, StringView rhs) noexcept
+  {
+    return lhs.size() == rhs.size() &&
+      (lhs.size() == 0 || std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+  }
+
+  inline
+  bool
+  operator!=(StringView lhs, StringView rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+
+  namespace values
+  {
+    struct SlotOps;
+  } // namespace values
+
 #if defined(__GNUC__)
 // GNU GCC with -Weffc++ will issue a warning regarding the upcoming class, we want to silence it:
 // warning: base class 'class std::enable_shared_from_this<cxxopts::Value>' has accessible non-virtual destructor
@@ -331,9 +445,14 @@ namespace cxxopts
     virtual void
     parse(const std::string& text) const = 0;
 
+    // Stores the default value.
     virtual void
     parse() const = 0;
 
+    // Stores the implicit value.
+    virtual void
+    parse_implicit() const = 0;
+
     virtual bool
     has_default() const = 0;
 
@@ -360,6 +479,30 @@ namespace cxxopts
 
     virtual bool
     is_boolean() const = 0;
+
+    // True if parsed values are written to a variable given to value(T&).
+    virtual bool
+    is_bound() const = 0;
+
+    // How a parse result stores a value of this type.
+    virtual const values::SlotOps&
+    slot_ops() const = 0;
+
+    // The variable given to value(T&), or nullptr.
+    virtual void*
+    bound_store() const = 0;
+
+    // The converted default and implicit values, or nullptr if there are
+    // none. They have the type described by slot_ops().
+    virtual const void*
+    default_parsed() const = 0;
+
+    virtual const void*
+    implicit_parsed() const = 0;
+
+    // Identifies the type of the stored value, see values::type_id.
+    virtual const void*
+    type() const = 0;
   };
 #if defined(__GNUC__)
 #pragma GCC diagnostic pop
@@ -512,6 +655,16 @@ namespace cxxopts
     }
   };
 
+  class invalid_option_type_error : public OptionSpecException
+  {
+    public:
+    explicit invalid_option_type_error(const std::string& option)
+    : OptionSpecException("Option " + LQUOTE + option + RQUOTE +
+        " does not hold a value of the requested type")
+    {
+    }
+  };
+
   class option_required_exception : public OptionParseException
   {
     public:
@@ -523,6 +676,18 @@ namespace cxxopts
     }
   };
 
+  class command_syntax_exception : public OptionParseException
+  {
+    public:
+    explicit command_syntax_exception(const std::string& command)
+    : OptionParseException(
+        "Command " + LQUOTE + command + RQUOTE +
+        " ends inside a quote or after a backslash"
+      )
+    {
+    }
+  };
+
   template <typename T>
   void throw_or_mimic(const std::string& text)
   {
@@ -552,280 +717,490 @@ namespace cxxopts
         std::string base     = "";
         std::string value    = "";
       };
+      enum class ArgumentKind : unsigned char
+      {
+        // a positional argument
+        Bare,
+        // "-" on its own, which is also positional
+        LoneDash,
+        // "--", after which everything is positional
+        EndOfOptions,
+        // --name
+        Long,
+        // --name=value
+        LongWithValue,
+        // -abc, a group of short options
+        ShortGroup,
+        // starts with a '-' but is none of the above
+        Malformed,
+      };
+
+      // One classified element of argv: its kind, its length and, for
+      // --name=value, the offset of the '='. The name and value are views
+      // derived from those, so describing an argument never allocates.
       struct ArguDesc {
-        std::string arg_name  = "";
-        bool        grouping  = false;
-        bool        set_value = false;
-        std::string value     = "";
+        const char*  text   = "";
+        std::size_t  length = 0;
+        std::size_t  equals = 0;
+        ArgumentKind kind   = ArgumentKind::Bare;
+
+        bool
+        is_option() const
+        {
+          return kind == ArgumentKind::Long ||
+                 kind == ArgumentKind::LongWithValue ||
+                 kind == ArgumentKind::ShortGroup;
+        }
+
+        bool
+        grouping() const
+        {
+          return kind == ArgumentKind::ShortGroup;
+        }
+
+        bool
+        set_value() const
+        {
+          return kind == ArgumentKind::LongWithValue;
+        }
+
+        StringView
+        token() const
+        {
+          return StringView(text, length);
+        }
+
+        StringView
+        arg_name() const
+        {
+          switch (kind)
+          {
+            case ArgumentKind::Long:
+              return StringView(text + 2, length - 2);
+            case ArgumentKind::LongWithValue:
+              return StringView(text + 2, equals - 2);
+            case ArgumentKind::ShortGroup:
+              return StringView(text + 1, length - 1);
+            default:
+              return StringView();
+          }
+        }
+
+        StringView
+        value() const
+        {
+          return set_value()
+            ? StringView(text + equals + 1, length - equals - 1)
+            : StringView();
+        }
       };
-#ifdef CXXOPTS_NO_REGEX
+
+      // The scanners below recognise exactly the languages of the following
+      // regular expressions (ECMAScript syntax, full match, classic locale),
+      // and produce the same sub-matches. Each one makes a single left to
+      // right pass over its input without backtracking.
+      //
+      //   integer:   (-)?(0x)?([0-9a-zA-Z]+)|((0x)?0)
+      //   true:      (t|T)(rue)?|1
+      //   false:     (f|F)(alse)?|0
+      //   argument:  --([[:alnum:]][-_[:alnum:]]+)(=(.*))?|-([[:alnum:]]+)
+      //   specifier: (([[:alnum:]]),)?[ ]*([[:alnum:]][-_[:alnum:]]*)?
+      //
+      // Character classes are ASCII only, so the result never depends on the
+      // global C locale.
+
+      inline bool IsAlnum(char c)
+      {
+        return (c >= '0' && c <= '9') ||
+               (c >= 'a' && c <= 'z') ||
+               (c >= 'A' && c <= 'Z');
+      }
+
+      inline bool IsNameChar(char c)
+      {
+        return IsAlnum(c) || c == '-' || c == '_';
+      }
+
+      // `.` in an ECMAScript regex matches anything but a line terminator.
+      inline bool IsAnyChar(char c)
+      {
+        return c != '\n' && c != '\r';
+      }
+
       inline IntegerDesc SplitInteger(const std::string &text)
       {
-        if (text.empty())
-        {
-          throw_or_mimic<argument_incorrect_type>(text);
-        }
+        const char* pdata = text.data();
+        const char* const end = pdata + text.size();
+
         IntegerDesc desc;
-        const char *pdata = text.c_str();
-        if (*pdata == '-')
+        if (pdata != end && *pdata == '-')
         {
-          pdata += 1;
           desc.negative = "-";
+          ++pdata;
         }
-        if (strncmp(pdata, "0x", 2) == 0)
+
+        const char* const digits = pdata;
+        while (pdata != end && IsAlnum(*pdata))
         {
-          pdata += 2;
-          desc.base = "0x";
+          ++pdata;
         }
-        if (*pdata != '\0')
+
+        // Either the remainder was not all alphanumeric, or it was empty.
+        if (pdata != end || pdata == digits)
+        {
+          throw_or_mimic<argument_incorrect_type>(text);
+        }
+
+        // `(0x)?` only takes the prefix when there is at least one character
+        // left over for `[0-9a-zA-Z]+`. Every string accepted by the second
+        // alternative, `(0x)?0`, is also accepted by the first one, which is
+        // tried first, so that alternative never produces a match.
+        if (end - digits > 2 && digits[0] == '0' && digits[1] == 'x')
         {
-          desc.value = std::string(pdata);
+          desc.base = "0x";
+          desc.value.assign(digits + 2, end);
         }
         else
         {
-          throw_or_mimic<argument_incorrect_type>(text);
+          desc.value.assign(digits, end);
         }
+
         return desc;
       }
 
       inline bool IsTrueText(const std::string &text)
       {
-        const char *pdata = text.c_str();
-        if (*pdata == 't' || *pdata == 'T')
-        {
-          pdata += 1;
-          if (strncmp(pdata, "rue\0", 4) == 0)
-          {
-            return true;
-          }
-        }
-        else if (strncmp(pdata, "1\0", 2) == 0)
+        switch (text.size())
         {
-          return true;
+          case 1:
+            return text[0] == 't' || text[0] == 'T' || text[0] == '1';
+          case 4:
+            return (text[0] == 't' || text[0] == 'T') &&
+              text.compare(1, 3, "rue") == 0;
+          default:
+            return false;
         }
-        return false;
       }
 
       inline bool IsFalseText(const std::string &text)
       {
-        const char *pdata = text.c_str();
-        if (*pdata == 'f' || *pdata == 'F')
+        switch (text.size())
         {
-          pdata += 1;
-          if (strncmp(pdata, "alse\0", 5) == 0)
-          {
-            return true;
-          }
-        }
-        else if (strncmp(pdata, "0\0", 2) == 0)
-        {
-          return true;
+          case 1:
+            return text[0] == 'f' || text[0] == 'F' || text[0] == '0';
+          case 5:
+            return (text[0] == 'f' || text[0] == 'F') &&
+              text.compare(1, 4, "alse") == 0;
+          default:
+            return false;
         }
-        return false;
       }
 
       inline std::pair<std::string, std::string> SplitSwitchDef(const std::string &text)
       {
         std::string short_sw, long_sw;
         const char *pdata = text.c_str();
-        if (isalnum(*pdata) && *(pdata + 1) == ',') {
-          short_sw = std::string(1, *pdata);
+
+        // A short switch needs its comma; without it the leading character
+        // is the start of the long switch instead.
+        if (IsAlnum(pdata[0]) && pdata[1] == ',')
+        {
+          short_sw.assign(1, pdata[0]);
           pdata += 2;
         }
-        while (*pdata == ' ') { pdata += 1; }
-        if (isalnum(*pdata)) {
+
+        while (*pdata == ' ')
+        {
+          ++pdata;
+        }
+
+        if (IsAlnum(*pdata))
+        {
           const char *store = pdata;
-          pdata += 1;
-          while (isalnum(*pdata) || *pdata == '-' || *pdata == '_') {
-            pdata += 1;
-          }
-          if (*pdata == '\0') {
-            long_sw = std::string(store, pdata - store);
-          } else {
-            throw_or_mimic<invalid_option_format_error>(text);
+          ++pdata;
+          while (IsNameChar(*pdata))
+          {
+            ++pdata;
           }
+          long_sw.assign(store, pdata);
+        }
+
+        if (*pdata != '\0')
+        {
+          throw_or_mimic<invalid_option_format_error>(text);
         }
+
         return std::pair<std::string, std::string>(short_sw, long_sw);
       }
 
-      inline ArguDesc ParseArgument(const char *arg, bool &matched)
+      // Classifies one argument of the given length. The characters of an
+      // option name are checked one at a time; a value is only searched for
+      // line terminators, with memchr, which the C library vectorises.
+      inline ArguDesc ParseArgument(const char *arg, std::size_t length)
       {
-        ArguDesc argu_desc;
+        ArguDesc desc;
+        desc.text = arg;
+        desc.length = length;
+        const char* const end = arg + length;
         const char *pdata = arg;
-        matched = false;
-        if (strncmp(pdata, "--", 2) == 0)
+
+        if (length == 0 || pdata[0] != '-')
+        {
+          desc.kind = ArgumentKind::Bare;
+          return desc;
+        }
+
+        if (length == 1)
+        {
+          desc.kind = ArgumentKind::LoneDash;
+          return desc;
+        }
+
+        if (pdata[1] == '-')
         {
+          // --name or --name=value, where the name is at least two
+          // characters long
           pdata += 2;
-          if (isalnum(*pdata))
+          if (pdata == end)
+          {
+            desc.kind = ArgumentKind::EndOfOptions;
+            return desc;
+          }
+
+          const char *name = pdata;
+          if (IsAlnum(*pdata))
           {
-            argu_desc.arg_name.push_back(*pdata);
-            pdata += 1;
-            while (isalnum(*pdata) || *pdata == '-' || *pdata == '_')
+            ++pdata;
+            while (pdata != end && IsNameChar(*pdata))
             {
-              argu_desc.arg_name.push_back(*pdata);
-              pdata += 1;
+              ++pdata;
             }
-            if (argu_desc.arg_name.length() > 1)
+          }
+
+          if (pdata - name >= 2)
+          {
+            if (pdata == end)
             {
-              if (*pdata == '=')
-              {
-                argu_desc.set_value = true;
-                pdata += 1;
-                if (*pdata != '\0')
-                {
-                  argu_desc.value = std::string(pdata);
-                }
-                matched = true;
-              }
-              else if (*pdata == '\0')
-              {
-                matched = true;
-              }
+              desc.kind = ArgumentKind::Long;
+              return desc;
+            }
+
+            if (*pdata == '=')
+            {
+              const char *value = pdata + 1;
+              const size_t value_length = static_cast<size_t>(end - value);
+              desc.equals = static_cast<size_t>(pdata - arg);
+              desc.kind =
+                std::memchr(value, '\n', value_length) == nullptr &&
+                std::memchr(value, '\r', value_length) == nullptr
+                ? ArgumentKind::LongWithValue
+                : ArgumentKind::Malformed;
+              return desc;
             }
           }
         }
-        else if (strncmp(pdata, "-", 1) == 0)
+        else
         {
-          pdata += 1;
-          argu_desc.grouping = true;
-          while (isalnum(*pdata))
+          // -abc, a group of one or more short options
+          ++pdata;
+          while (pdata != end && IsAlnum(*pdata))
           {
-            argu_desc.arg_name.push_back(*pdata);
-            pdata += 1;
+            ++pdata;
           }
-          matched = !argu_desc.arg_name.empty() && *pdata == '\0';
-        }
-        return argu_desc;
-      }
-
-#else  // CXXOPTS_NO_REGEX
 
-      namespace
-      {
-
-        std::basic_regex<char> integer_pattern
-          ("(-)?(0x)?([0-9a-zA-Z]+)|((0x)?0)");
-        std::basic_regex<char> truthy_pattern
-          ("(t|T)(rue)?|1");
-        std::basic_regex<char> falsy_pattern
-          ("(f|F)(alse)?|0");
-
-        std::basic_regex<char> option_matcher
-          ("--([[:alnum:]][-_[:alnum:]]+)(=(.*))?|-([[:alnum:]]+)");
-        std::basic_regex<char> option_specifier
-          ("(([[:alnum:]]),)?[ ]*([[:alnum:]][-_[:alnum:]]*)?");
-
-      } // namespace
-
-      inline IntegerDesc SplitInteger(const std::string &text)
-      {
-        std::smatch match;
-        std::regex_match(text, match, integer_pattern);
-
-        if (match.length() == 0)
-        {
-          throw_or_mimic<argument_incorrect_type>(text);
-        }
-
-        IntegerDesc desc;
-        desc.negative = match[1];
-        desc.base = match[2];
-        desc.value = match[3];
-
-        if (match.length(4) > 0)
-        {
-          desc.base = match[5];
-          desc.value = "0";
-          return desc;
+          if (pdata == end)
+          {
+            desc.kind = ArgumentKind::ShortGroup;
+            return desc;
+          }
         }
 
+        desc.kind = ArgumentKind::Malformed;
         return desc;
       }
 
-      inline bool IsTrueText(const std::string &text)
+      inline ArguDesc ParseArgument(const char *arg)
       {
-        std::smatch result;
-        std::regex_match(text, result, truthy_pattern);
-        return !result.empty();
+        return ParseArgument(arg, std::strlen(arg));
       }
 
-      inline bool IsFalseText(const std::string &text)
-      {
-        std::smatch result;
-        std::regex_match(text, result, falsy_pattern);
-        return !result.empty();
-      }
+      // Splitting command strings. Unlike the scanners above, these follow
+      // the quoting rules of a POSIX shell rather than a regular expression.
 
-      inline std::pair<std::string, std::string> SplitSwitchDef(const std::string &text)
+      // Characters that end a run of plain text in a shell command.
+      inline bool IsShellSpecial(char c)
       {
-        std::match_results<const char*> result;
-        std::regex_match(text.c_str(), result, option_specifier);
-        if (result.empty())
-        {
-          throw_or_mimic<invalid_option_format_error>(text);
-        }
-
-        const std::string& short_sw = result[2];
-        const std::string& long_sw = result[3];
-
-        return std::pair<std::string, std::string>(short_sw, long_sw);
+        return c == ' ' || c == '\t' || c == '\n' ||
+               c == '\'' || c == '"' || c == '\\';
       }
 
-      inline ArguDesc ParseArgument(const char *arg, bool &matched)
+      // Splits a command into words with the quoting of a POSIX shell, and
+      // writes each word to `buffer` followed by a '\0', adding a pointer to
+      // it to `argv`. The buffer is reserved up front, so the pointers stay
+      // valid. Runs of plain text are found first and copied in one go.
+      // Returns false if the command ends inside a quote or after a
+      // backslash, leaving the words before that point in `argv`, the last
+      // of them cut short but still terminated.
+      inline bool SplitCommand(StringView command, std::vector<char>& buffer,
+        std::vector<const char*>& argv)
       {
-        std::match_results<const char*> result;
-        std::regex_match(arg, result, option_matcher);
-        matched = !result.empty();
+        // a word is never longer than the text it comes from, and is
+        // followed by at least one blank or the end
+        buffer.clear();
+        buffer.reserve(command.size() + 1);
+        argv.clear();
+
+        const char* p = command.data();
+        const char* const end = p + command.size();
+        bool in_word = false;
 
-        ArguDesc argu_desc;
-        if (matched) {
-          argu_desc.arg_name = result[1].str();
-          argu_desc.set_value = result[2].length() > 0;
-          argu_desc.value = result[3].str();
-          if (result[4].length() > 0)
+        auto start_word = [&]
+        {
+          if (!in_word)
           {
-            argu_desc.grouping = true;
-            argu_desc.arg_name = result[4].str();
+            argv.push_back(buffer.data() + buffer.size());
+            in_word = true;
           }
-        }
+        };
 
-        return argu_desc;
-      }
-
-#endif  // CXXOPTS_NO_REGEX
-#undef CXXOPTS_NO_REGEX
-  }
-
-    namespace detail
-    {
-      template <typename T, bool B>
-      struct SignedCheck;
+        auto unterminated = [&]
+        {
+          if (in_word)
+          {
+            buffer.push_back('\0');
+          }
+          return false;
+        };
 
-      template <typename T>
-      struct SignedCheck<T, true>
-      {
-        template <typename U>
-        void
-        operator()(bool negative, U u, const std::string& text)
+        while (p != end)
         {
-          if (negative)
+          const char* plain = p;
+          while (plain != end && !IsShellSpecial(*plain))
           {
-            if (u > static_cast<U>((std::numeric_limits<T>::min)()))
-            {
-              throw_or_mimic<argument_incorrect_type>(text);
-            }
+            ++plain;
           }
-          else
+
+          if (plain != p)
           {
-            if (u > static_cast<U>((std::numeric_limits<T>::max)()))
-            {
-              throw_or_mimic<argument_incorrect_type>(text);
-            }
+            start_word();
+            buffer.insert(buffer.end(), p, plain);
+            p = plain;
+            continue;
           }
-        }
-      };
 
-      template <typename T>
+          switch (*p)
+          {
+            case '\'':
+            {
+              // everything up to the next single quote, as it is
+              const auto* close = static_cast<const char*>(std::memchr(p + 1,
+                '\'', static_cast<std::size_t>(end - p - 1)));
+              if (close == nullptr)
+              {
+                return unterminated();
+              }
+              start_word();
+              buffer.insert(buffer.end(), p + 1, close);
+              p = close + 1;
+              break;
+            }
+
+            case '"':
+              start_word();
+              ++p;
+              for (;;)
+              {
+                if (p == end)
+                {
+                  return unterminated();
+                }
+                if (*p == '"')
+                {
+                  ++p;
+                  break;
+                }
+                // a backslash only escapes these inside double quotes
+                if (*p == '\\' && p + 1 != end &&
+                    (p[1] == '$' || p[1] == '`' || p[1] == '"' ||
+                     p[1] == '\\' || p[1] == '\n'))
+                {
+                  if (p[1] != '\n')
+                  {
+                    buffer.push_back(p[1]);
+                  }
+                  p += 2;
+                  continue;
+                }
+                buffer.push_back(*p);
+                ++p;
+              }
+              break;
+
+            case '\\':
+              if (p + 1 == end)
+              {
+                return unterminated();
+              }
+              // a backslash and a newline join two lines
+              if (p[1] != '\n')
+              {
+                start_word();
+                buffer.push_back(p[1]);
+              }
+              p += 2;
+              break;
+
+            default:
+              // a blank ends the word
+              if (in_word)
+              {
+                buffer.push_back('\0');
+                in_word = false;
+              }
+              ++p;
+              break;
+          }
+        }
+
+        if (in_word)
+        {
+          buffer.push_back('\0');
+        }
+
+        return true;
+      }
+  }
+
+    namespace detail
+    {
+      template <typename T, bool B>
+      struct SignedCheck;
+
+      template <typename T>
+      struct SignedCheck<T, true>
+      {
+        template <typename U>
+        void
+        operator()(bool negative, U u, const std::string& text)
+        {
+          if (negative)
+          {
+            if (u > static_cast<U>((std::numeric_limits<T>::min)()))
+            {
+              throw_or_mimic<argument_incorrect_type>(text);
+            }
+          }
+          else
+          {
+            if (u > static_cast<U>((std::numeric_limits<T>::max)()))
+            {
+              throw_or_mimic<argument_incorrect_type>(text);
+            }
+          }
+        }
+      };
+
+      template <typename T>
       struct SignedCheck<T, false>
       {
         template <typename U>
@@ -974,12 +1349,22 @@ namespace cxxopts
     void
     parse_value(const std::string& text, std::vector<T>& value)
     {
-      std::stringstream in(text);
+      // split without a stream, which would allocate; as with getline, an
+      // empty last element is dropped
       std::string token;
-      while(!in.eof() && std::getline(in, token, CXXOPTS_VECTOR_DELIMITER)) {
+      std::size_t start = 0;
+      while (start < text.size())
+      {
+        auto end = text.find(CXXOPTS_VECTOR_DELIMITER, start);
+        if (end == std::string::npos)
+        {
+          end = text.size();
+        }
+        token.assign(text, start, end - start);
         T v;
         parse_value(token, v);
         value.emplace_back(std::move(v));
+        start = end + 1;
       }
     }
 
@@ -1005,12 +1390,136 @@ namespace cxxopts
       c = text[0];
     }
 
+    // Adds an already converted value to a store, the way parse_value adds
+    // the value it converts: containers are appended to, anything else is
+    // replaced.
+    template <typename T>
+    void
+    add_value(const T& value, T& store)
+    {
+      store = value;
+    }
+
+    template <typename T>
+    void
+    add_value(const std::vector<T>& value, std::vector<T>& store)
+    {
+      store.insert(store.end(), value.begin(), value.end());
+    }
+
+    // Returns a store to its default constructed value. Strings and
+    // containers keep their storage, so that the store can be reused.
+    template <typename T>
+    void
+    clear_value(T& store)
+    {
+      store = T();
+    }
+
+    inline
+    void
+    clear_value(std::string& store)
+    {
+      store.clear();
+    }
+
+    template <typename T>
+    void
+    clear_value(std::vector<T>& store)
+    {
+      store.clear();
+    }
+
+    // Converts text the way parse_value does, only to report any error.
+    // Text that cannot fail to convert is not copied at all.
+    template <typename T>
+    void
+    check_value(const std::string& text, const T*)
+    {
+      T value{};
+      parse_value(text, value);
+    }
+
+    inline
+    void
+    check_value(const std::string&, const std::string*)
+    {
+    }
+
+    inline
+    void
+    check_value(const std::string&, const std::vector<std::string>*)
+    {
+    }
+
+    // The text shown in the help for a typed default or implicit value.
+    template <typename T,
+             typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr
+             >
+    std::string
+    value_text(const T& value)
+    {
+      std::ostringstream out;
+      out << value;
+      return out.str();
+    }
+
+    inline
+    std::string
+    value_text(bool value)
+    {
+      return value ? "true" : "false";
+    }
+
+    inline
+    std::string
+    value_text(char value)
+    {
+      return std::string(1, value);
+    }
+
+    template <typename T>
+    std::string
+    value_text(const std::vector<T>& value)
+    {
+      std::string text;
+      for (const auto& element : value)
+      {
+        if (!text.empty())
+        {
+          text += CXXOPTS_VECTOR_DELIMITER;
+        }
+        text += value_text(element);
+      }
+      return text;
+    }
+
     template <typename T>
     struct type_is_container
     {
       static constexpr bool value = false;
     };
 
+    // The operations on one type of value that a ValueSlot needs, so that a
+    // slot can hold any type without a virtual call or an allocation.
+    struct SlotOps
+    {
+      const void* type;
+      std::size_t size;
+      std::size_t alignment;
+      // whether move cannot throw, so the value may be kept inline
+      bool nothrow_move;
+      void (*construct)(void* where);
+      void (*copy)(void* where, const void* from);
+      void (*move)(void* where, void* from);
+      void (*destroy)(void* value);
+      void (*parse)(const std::string& text, void* value);
+      void (*add)(const void* from, void* value);
+      void (*clear)(void* value);
+      // reports any error in converting text, see check_value
+      void (*check)(const std::string& text);
+    };
+
     template <typename T>
     struct type_is_container<std::vector<T>>
     {
@@ -1018,149 +1527,550 @@ namespace cxxopts
     };
 
     template <typename T>
-    class abstract_value : public Value
+    struct type_tag
     {
-      using Self = abstract_value<T>;
+      static const char id;
+    };
 
-      public:
-      abstract_value()
-      : m_result(std::make_shared<T>())
-      , m_store(m_result.get())
+    template <typename T>
+    const char type_tag<T>::id = 0;
+
+    // A distinct address for every type, which lets stored values be type
+    // checked without RTTI.
+    template <typename T>
+    constexpr const void*
+    type_id()
+    {
+      return &type_tag<T>::id;
+    }
+
+    template <typename T>
+    struct value_ops
+    {
+      static void
+      construct(void* where)
       {
+        new (where) T();
       }
 
-      explicit abstract_value(T* t)
-      : m_store(t)
+      static void
+      copy(void* where, const void* from)
       {
+        new (where) T(*static_cast<const T*>(from));
       }
 
-      ~abstract_value() override = default;
-
-      abstract_value& operator=(const abstract_value&) = default;
-
-      abstract_value(const abstract_value& rhs)
+      static void
+      move(void* where, void* from)
       {
-        if (rhs.m_result)
-        {
-          m_result = std::make_shared<T>();
-          m_store = m_result.get();
-        }
-        else
-        {
-          m_store = rhs.m_store;
-        }
-
-        m_default = rhs.m_default;
-        m_implicit = rhs.m_implicit;
-        m_default_value = rhs.m_default_value;
-        m_implicit_value = rhs.m_implicit_value;
+        new (where) T(std::move(*static_cast<T*>(from)));
       }
 
-      void
-      parse(const std::string& text) const override
+      static void
+      destroy(void* value)
       {
-        parse_value(text, *m_store);
+        static_cast<T*>(value)->~T();
       }
 
-      bool
-      is_container() const override
+      static void
+      parse(const std::string& text, void* value)
       {
-        return type_is_container<T>::value;
+        parse_value(text, *static_cast<T*>(value));
       }
 
-      void
-      parse() const override
+      static void
+      add(const void* from, void* value)
       {
-        parse_value(m_default_value, *m_store);
+        add_value(*static_cast<const T*>(from), *static_cast<T*>(value));
       }
 
-      bool
-      has_default() const override
+      static void
+      clear(void* value)
       {
-        return m_default;
+        clear_value(*static_cast<T*>(value));
       }
 
-      bool
-      has_implicit() const override
+      static void
+      check(const std::string& text)
       {
-        return m_implicit;
+        check_value(text, static_cast<const T*>(nullptr));
       }
 
-      std::shared_ptr<Value>
-      default_value(const std::string& value) override
+      static const SlotOps ops;
+    };
+
+    template <typename T>
+    const SlotOps value_ops<T>::ops = {
+      type_id<T>(),
+      sizeof(T),
+      alignof(T),
+      std::is_nothrow_move_constructible<T>::value,
+      &value_ops<T>::construct,
+      &value_ops<T>::copy,
+      &value_ops<T>::move,
+      &value_ops<T>::destroy,
+      &value_ops<T>::parse,
+      &value_ops<T>::add,
+      &value_ops<T>::clear,
+      &value_ops<T>::check,
+    };
+
+    // Storage for one parsed value. Values that fit and cannot throw when
+    // moved are kept in the slot itself, others on the heap, and a value
+    // bound to a variable is written straight to that variable. Moving a
+    // slot never moves a value that could throw.
+    class ValueSlot
+    {
+      public:
+      ValueSlot() = default;
+
+      ValueSlot(const ValueSlot& rhs)
       {
-        m_default = true;
-        m_default_value = value;
-        return shared_from_this();
+        assign(rhs);
       }
 
-      std::shared_ptr<Value>
-      implicit_value(const std::string& value) override
+      ValueSlot(ValueSlot&& rhs) noexcept
       {
-        m_implicit = true;
-        m_implicit_value = value;
-        return shared_from_this();
+        take(rhs);
       }
 
-      std::shared_ptr<Value>
-      no_implicit_value() override
+      ValueSlot&
+      operator=(const ValueSlot& rhs)
       {
-        m_implicit = false;
-        return shared_from_this();
+        if (this != &rhs)
+        {
+          reset();
+          assign(rhs);
+        }
+        return *this;
       }
 
-      std::string
-      get_default_value() const override
+      ValueSlot&
+      operator=(ValueSlot&& rhs) noexcept
       {
-        return m_default_value;
+        if (this != &rhs)
+        {
+          reset();
+          take(rhs);
+        }
+        return *this;
       }
 
-      std::string
-      get_implicit_value() const override
+      ~ValueSlot()
       {
-        return m_implicit_value;
+        reset();
       }
 
-      bool
-      is_boolean() const override
+      // Creates a default constructed value, or refers to `bound` if it is
+      // not null.
+      void
+      emplace(const SlotOps& ops, void* bound)
       {
-        return std::is_same<T, bool>::value;
+        reset();
+
+        if (bound != nullptr)
+        {
+          m_value = bound;
+          m_storage = Storage::Bound;
+        }
+        else
+        {
+          m_value = allocate(ops);
+          ops.construct(m_value);
+        }
+
+        m_ops = &ops;
       }
 
-      const T&
-      get() const
+      // Default constructs the value again, keeping its storage. A bound
+      // variable is left as it is.
+      void
+      clear()
       {
-        if (m_store == nullptr)
+        if (m_ops != nullptr && m_storage != Storage::Bound)
         {
-          return *m_result;
+          m_ops->clear(m_value);
         }
-        return *m_store;
       }
 
-      protected:
-      std::shared_ptr<T> m_result{};
-      T* m_store{};
-
-      bool m_default = false;
-      bool m_implicit = false;
-
-      std::string m_default_value{};
-      std::string m_implicit_value{};
-    };
-
-    template <typename T>
-    class standard_value : public abstract_value<T>
-    {
-      public:
-      using abstract_value<T>::abstract_value;
+      bool
+      empty() const noexcept
+      {
+        return m_ops == nullptr;
+      }
 
-      CXXOPTS_NODISCARD
-      std::shared_ptr<Value>
-      clone() const override
+      const SlotOps*
+      ops() const noexcept
       {
-        return std::make_shared<standard_value<T>>(*this);
+        return m_ops;
       }
-    };
+
+      void*
+      get() noexcept
+      {
+        return m_value;
+      }
+
+      const void*
+      get() const noexcept
+      {
+        return m_value;
+      }
+
+      private:
+      enum class Storage : unsigned char
+      {
+        Inline,
+        Heap,
+        Bound,
+      };
+
+      static constexpr std::size_t buffer_size = 4 * sizeof(void*);
+
+      void*
+      allocate(const SlotOps& ops)
+      {
+        if (ops.nothrow_move && ops.size <= buffer_size &&
+            ops.alignment <= alignof(std::max_align_t))
+        {
+          m_storage = Storage::Inline;
+          return m_buffer;
+        }
+
+        m_storage = Storage::Heap;
+        return ::operator new(ops.size);
+      }
+
+      void
+      assign(const ValueSlot& rhs)
+      {
+        if (rhs.m_ops == nullptr)
+        {
+          return;
+        }
+
+        if (rhs.m_storage == Storage::Bound)
+        {
+          m_value = rhs.m_value;
+          m_storage = Storage::Bound;
+        }
+        else
+        {
+          void* value = allocate(*rhs.m_ops);
+          try_copy(*rhs.m_ops, value, rhs.m_value);
+          m_value = value;
+        }
+
+        m_ops = rhs.m_ops;
+      }
+
+      void
+      try_copy(const SlotOps& ops, void* value, const void* from)
+      {
+#ifndef CXXOPTS_NO_EXCEPTIONS
+        try
+        {
+#endif
+          ops.copy(value, from);
+#ifndef CXXOPTS_NO_EXCEPTIONS
+        }
+        catch (...)
+        {
+          if (m_storage == Storage::Heap)
+          {
+            ::operator delete(value);
+          }
+          throw;
+        }
+#endif
+      }
+
+      void
+      take(ValueSlot& rhs) noexcept
+      {
+        if (rhs.m_ops == nullptr)
+        {
+          return;
+        }
+
+        m_ops = rhs.m_ops;
+        m_storage = rhs.m_storage;
+
+        if (m_storage == Storage::Inline)
+        {
+          // only types that cannot throw when moved are kept inline
+          m_value = m_buffer;
+          m_ops->move(m_value, rhs.m_value);
+          rhs.reset();
+        }
+        else
+        {
+          m_value = rhs.m_value;
+          rhs.m_ops = nullptr;
+          rhs.m_value = nullptr;
+        }
+      }
+
+      void
+      reset() noexcept
+      {
+        if (m_ops == nullptr)
+        {
+          return;
+        }
+
+        if (m_storage != Storage::Bound)
+        {
+          m_ops->destroy(m_value);
+        }
+
+        if (m_storage == Storage::Heap)
+        {
+          ::operator delete(m_value);
+        }
+
+        m_ops = nullptr;
+        m_value = nullptr;
+      }
+
+      const SlotOps* m_ops = nullptr;
+      void* m_value = nullptr;
+      Storage m_storage = Storage::Inline;
+      alignas(std::max_align_t) unsigned char m_buffer[buffer_size] = {};
+    };
+
+    template <typename T>
+    class abstract_value : public Value
+    {
+      using Self = abstract_value<T>;
+
+      public:
+      abstract_value()
+      : m_result(std::make_shared<T>())
+      , m_store(m_result.get())
+      {
+      }
+
+      explicit abstract_value(T* t)
+      : m_store(t)
+      {
+      }
+
+      ~abstract_value() override = default;
+
+      abstract_value& operator=(const abstract_value&) = default;
+
+      abstract_value(const abstract_value& rhs)
+      {
+        if (rhs.m_result)
+        {
+          m_result = std::make_shared<T>();
+          m_store = m_result.get();
+        }
+        else
+        {
+          m_store = rhs.m_store;
+        }
+
+        m_default = rhs.m_default;
+        m_implicit = rhs.m_implicit;
+        m_default_value = rhs.m_default_value;
+        m_implicit_value = rhs.m_implicit_value;
+        m_default_parsed = rhs.m_default_parsed;
+        m_implicit_parsed = rhs.m_implicit_parsed;
+      }
+
+      void
+      parse(const std::string& text) const override
+      {
+        parse_value(text, *m_store);
+      }
+
+      bool
+      is_container() const override
+      {
+        return type_is_container<T>::value;
+      }
+
+      void
+      parse() const override
+      {
+        add_value(*m_default_parsed, *m_store);
+      }
+
+      void
+      parse_implicit() const override
+      {
+        add_value(*m_implicit_parsed, *m_store);
+      }
+
+      bool
+      has_default() const override
+      {
+        return m_default;
+      }
+
+      bool
+      has_implicit() const override
+      {
+        return m_implicit;
+      }
+
+      // The default and implicit values are converted here, once, and the
+      // converted values are shared by every copy made for a parse.
+      std::shared_ptr<Value>
+      default_value(const std::string& value) override
+      {
+        auto parsed = std::make_shared<T>();
+        parse_value(value, *parsed);
+
+        m_default = true;
+        m_default_value = value;
+        m_default_parsed = std::move(parsed);
+        return shared_from_this();
+      }
+
+      std::shared_ptr<Value>
+      implicit_value(const std::string& value) override
+      {
+        auto parsed = std::make_shared<T>();
+        parse_value(value, *parsed);
+
+        m_implicit = true;
+        m_implicit_value = value;
+        m_implicit_parsed = std::move(parsed);
+        return shared_from_this();
+      }
+
+      // Typed overloads, which take a value of exactly the option's type
+      // and store it without converting it from text. Strings use the
+      // overloads above.
+      template <typename U,
+               typename std::enable_if<
+                 std::is_same<typename std::decay<U>::type, T>::value &&
+                 !std::is_same<T, std::string>::value>::type* = nullptr
+               >
+      std::shared_ptr<Self>
+      default_value(U&& value)
+      {
+        m_default = true;
+        m_default_value = value_text(value);
+        m_default_parsed = std::make_shared<T>(std::forward<U>(value));
+        return std::static_pointer_cast<Self>(shared_from_this());
+      }
+
+      template <typename U,
+               typename std::enable_if<
+                 std::is_same<typename std::decay<U>::type, T>::value &&
+                 !std::is_same<T, std::string>::value>::type* = nullptr
+               >
+      std::shared_ptr<Self>
+      implicit_value(U&& value)
+      {
+        m_implicit = true;
+        m_implicit_value = value_text(value);
+        m_implicit_parsed = std::make_shared<T>(std::forward<U>(value));
+        return std::static_pointer_cast<Self>(shared_from_this());
+      }
+
+      std::shared_ptr<Value>
+      no_implicit_value() override
+      {
+        m_implicit = false;
+        m_implicit_parsed.reset();
+        return shared_from_this();
+      }
+
+      std::string
+      get_default_value() const override
+      {
+        return m_default_value;
+      }
+
+      std::string
+      get_implicit_value() const override
+      {
+        return m_implicit_value;
+      }
+
+      bool
+      is_boolean() const override
+      {
+        return std::is_same<T, bool>::value;
+      }
+
+      bool
+      is_bound() const override
+      {
+        return m_result == nullptr;
+      }
+
+      const SlotOps&
+      slot_ops() const override
+      {
+        return value_ops<T>::ops;
+      }
+
+      void*
+      bound_store() const override
+      {
+        return m_result == nullptr ? m_store : nullptr;
+      }
+
+      const void*
+      default_parsed() const override
+      {
+        return m_default_parsed.get();
+      }
+
+      const void*
+      implicit_parsed() const override
+      {
+        return m_implicit_parsed.get();
+      }
+
+      const void*
+      type() const override
+      {
+        return type_id<T>();
+      }
+
+      const T&
+      get() const
+      {
+        if (m_store == nullptr)
+        {
+          return *m_result;
+        }
+        return *m_store;
+      }
+
+      protected:
+      std::shared_ptr<T> m_result{};
+      T* m_store{};
+
+      bool m_default = false;
+      bool m_implicit = false;
+
+      std::string m_default_value{};
+      std::string m_implicit_value{};
+
+      std::shared_ptr<const T> m_default_parsed{};
+      std::shared_ptr<const T> m_implicit_parsed{};
+    };
+
+    template <typename T>
+    class standard_value : public abstract_value<T>
+    {
+      public:
+      using abstract_value<T>::abstract_value;
+
+      CXXOPTS_NODISCARD
+      std::shared_ptr<Value>
+      clone() const override
+      {
+        return std::make_shared<standard_value<T>>(*this);
+      }
+    };
 
     template <>
     class standard_value<bool> : public abstract_value<bool>
@@ -1190,23 +2100,29 @@ namespace cxxopts
       void
       set_default_and_implicit()
       {
+        // shared by every boolean option
+        static const std::shared_ptr<const bool> no = std::make_shared<bool>(false);
+        static const std::shared_ptr<const bool> yes = std::make_shared<bool>(true);
+
         m_default = true;
         m_default_value = "false";
+        m_default_parsed = no;
         m_implicit = true;
         m_implicit_value = "true";
+        m_implicit_parsed = yes;
       }
     };
   } // namespace values
 
   template <typename T>
-  std::shared_ptr<Value>
+  std::shared_ptr<values::standard_value<T>>
   value()
   {
     return std::make_shared<values::standard_value<T>>();
   }
 
   template <typename T>
-  std::shared_ptr<Value>
+  std::shared_ptr<values::standard_value<T>>
   value(T& t)
   {
     return std::make_shared<values::standard_value<T>>(&t);
@@ -1222,21 +2138,23 @@ namespace cxxopts
       std::string short_,
       std::string long_,
       String desc,
-      std::shared_ptr<const Value> val
+      std::shared_ptr<const Value> val,
+      std::size_t id
     )
     : m_short(std::move(short_))
     , m_long(std::move(long_))
     , m_desc(std::move(desc))
     , m_value(std::move(val))
     , m_count(0)
+    , m_id(id)
     {
-      m_hash = std::hash<std::string>{}(m_long + m_short);
     }
 
     OptionDetails(const OptionDetails& rhs)
     : m_desc(rhs.m_desc)
     , m_value(rhs.m_value->clone())
     , m_count(rhs.m_count)
+    , m_id(rhs.m_id)
     {
     }
 
@@ -1276,10 +2194,12 @@ namespace cxxopts
       return m_long;
     }
 
+    // The position of this option in the order that options were added
+    // to its Options. Every option has a distinct id.
     size_t
-    hash() const
+    id() const
     {
-      return m_hash;
+      return m_id;
     }
 
     private:
@@ -1289,7 +2209,7 @@ namespace cxxopts
     std::shared_ptr<const Value> m_value{};
     int m_count;
 
-    size_t m_hash{};
+    size_t m_id{};
   };
 
   struct HelpOptionDetails
@@ -1325,25 +2245,71 @@ namespace cxxopts
     {
       ensure_value(details);
       ++m_count;
-      m_value->parse(text);
+      m_value.ops()->parse(text, m_value.get());
       m_long_name = &details->long_name();
     }
 
     void
-    parse_default(const std::shared_ptr<const OptionDetails>& details)
+    parse_implicit(const std::shared_ptr<const OptionDetails>& details)
     {
       ensure_value(details);
-      m_default = true;
+      ++m_count;
+      m_value.ops()->add(details->value().implicit_parsed(), m_value.get());
       m_long_name = &details->long_name();
-      m_value->parse();
     }
 
+    // Records the text to be converted when the value is first read. Pass
+    // nullptr for the implicit value.
     void
-    parse_no_value(const std::shared_ptr<const OptionDetails>& details)
+    defer
+    (
+      const std::shared_ptr<const OptionDetails>& details,
+      const std::string* text
+    )
+    {
+      if (m_deferred == nullptr)
+      {
+        m_deferred = std::make_shared<Deferred>(details);
+      }
+
+      m_deferred->texts.emplace_back(text == nullptr ? std::string() : *text,
+        text == nullptr);
+      ++m_count;
+      m_long_name = &details->long_name();
+    }
+
+    // Converts a deferred value now, which reports any conversion error.
+    void
+    validate() const
+    {
+      stored();
+    }
+
+    void
+    parse_default(const std::shared_ptr<const OptionDetails>& details)
+    {
+      ensure_value(details);
+      m_default = true;
+      m_long_name = &details->long_name();
+      m_value.ops()->add(details->value().default_parsed(), m_value.get());
+    }
+
+    void
+    parse_no_value(const std::shared_ptr<const OptionDetails>& details)
     {
       m_long_name = &details->long_name();
     }
 
+    // Forgets the value, keeping its storage for the next parse into it.
+    void
+    clear()
+    {
+      m_value.clear();
+      m_deferred.reset();
+      m_count = 0;
+      m_default = false;
+    }
+
 #if defined(CXXOPTS_NULL_DEREF_IGNORE)
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wnull-dereference"
@@ -1372,37 +2338,169 @@ namespace cxxopts
     const T&
     as() const
     {
-      if (m_value == nullptr) {
+      return get<T>();
+    }
+
+    // The value, which must have exactly the type T.
+    template <typename T>
+    const T&
+    get() const
+    {
+      const auto& value = stored();
+
+      // a cleared value keeps its storage, but has no value
+      if (value.empty() || (m_count == 0 && !m_default)) {
           throw_or_mimic<option_has_no_value_exception>(
               m_long_name == nullptr ? "" : *m_long_name);
       }
 
-#ifdef CXXOPTS_NO_RTTI
-      return static_cast<const values::standard_value<T>&>(*m_value).get();
-#else
-      return dynamic_cast<const values::standard_value<T>&>(*m_value).get();
-#endif
+      if (value.ops()->type != values::type_id<T>()) {
+          throw_or_mimic<invalid_option_type_error>(
+              m_long_name == nullptr ? "" : *m_long_name);
+      }
+
+      return *static_cast<const T*>(value.get());
     }
 
     private:
+    // The texts of a lazily converted option and, once it has been read, the
+    // value converted from them. Copies of a result share it, and it may be
+    // read from several threads.
+    struct Deferred
+    {
+      explicit Deferred(std::shared_ptr<const OptionDetails> details_)
+      : details(std::move(details_))
+      {
+      }
+
+      std::shared_ptr<const OptionDetails> details;
+      // each text, and whether it stands for the implicit value
+      std::vector<std::pair<std::string, bool>> texts{};
+      values::ValueSlot value{};
+      std::atomic<bool> converted{false};
+      std::mutex mutex{};
+    };
+
+    const values::ValueSlot&
+    stored() const
+    {
+      if (m_deferred == nullptr)
+      {
+        return m_value;
+      }
+
+      auto& deferred = *m_deferred;
+      if (!deferred.converted.load(std::memory_order_acquire))
+      {
+        std::lock_guard<std::mutex> lock(deferred.mutex);
+        if (!deferred.converted.load(std::memory_order_relaxed))
+        {
+          // a failed conversion leaves nothing behind, and is tried again
+          // on the next read
+          const auto& schema = deferred.details->value();
+          const auto& ops = schema.slot_ops();
+
+          values::ValueSlot value;
+          value.emplace(ops, nullptr);
+          for (const auto& text : deferred.texts)
+          {
+            if (text.second)
+            {
+              ops.add(schema.implicit_parsed(), value.get());
+            }
+            else
+            {
+              ops.parse(text.first, value.get());
+            }
+          }
+
+          deferred.value = std::move(value);
+          deferred.converted.store(true, std::memory_order_release);
+        }
+      }
+
+      return deferred.value;
+    }
+
     void
     ensure_value(const std::shared_ptr<const OptionDetails>& details)
     {
-      if (m_value == nullptr)
+      if (m_value.empty())
       {
-        m_value = details->make_storage();
+        const auto& value = details->value();
+        m_value.emplace(value.slot_ops(), value.bound_store());
       }
     }
 
 
+    // Points into the OptionDetails that the value was parsed for. Values
+    // live in the id-indexed vectors of a ParseResult, which shares the
+    // OptionIndex that owns every named OptionDetails, so the name outlives
+    // them. A copy of an OptionValue taken out of its result is only valid
+    // while that result, or the options it was parsed with, still exists.
     const std::string* m_long_name = nullptr;
-    // Holding this pointer is safe, since OptionValue's only exist in key-value pairs,
-    // where the key has the string we point to.
-    std::shared_ptr<Value> m_value{};
+    values::ValueSlot m_value{};
+    std::shared_ptr<Deferred> m_deferred{};
     size_t m_count = 0;
     bool m_default = false;
   };
 
+  // Refers to an option whose value has type T, by its id in the Options
+  // it was added to. Reading a value through a handle needs no name lookup,
+  // see OptionAdder::add and ParseResult::get. A handle from OptionAdder::add
+  // also records its Options, and a result parsed with any other Options
+  // treats it as not present. A handle made from an id alone is not checked.
+  template <typename T>
+  class OptionHandle
+  {
+    public:
+    OptionHandle() = default;
+    OptionHandle(const OptionHandle&) = default;
+    OptionHandle(OptionHandle&&) = default;
+    OptionHandle& operator=(const OptionHandle&) = default;
+    OptionHandle& operator=(OptionHandle&&) = default;
+
+    explicit OptionHandle
+    (
+      std::size_t id,
+      std::string name = "",
+      const void* schema = nullptr
+    )
+    : m_id(id)
+    , m_name(std::move(name))
+    , m_schema(schema)
+    {
+    }
+
+    CXXOPTS_NODISCARD
+    std::size_t
+    id() const
+    {
+      return m_id;
+    }
+
+    CXXOPTS_NODISCARD
+    const std::string&
+    name() const
+    {
+      return m_name;
+    }
+
+    CXXOPTS_NODISCARD
+    const void*
+    schema() const
+    {
+      return m_schema;
+    }
+
+    private:
+    std::size_t m_id = static_cast<std::size_t>(-1);
+    std::string m_name{};
+    const void* m_schema = nullptr;
+  };
+
+  class ResultBuilder;
+
   class KeyValue
   {
     public:
@@ -1436,925 +2534,3544 @@ namespace cxxopts
     }
 
     private:
+    friend class ResultBuilder;
+
     std::string m_key;
     std::string m_value;
   };
 
-  using ParsedHashMap = std::unordered_map<size_t, OptionValue>;
-  using NameHashMap = std::unordered_map<std::string, size_t>;
+  using OptionMap = std::unordered_map<std::string, std::shared_ptr<OptionDetails>>;
+  // Short options indexed directly by their character.
+  using ShortOptionTable = std::array<std::shared_ptr<OptionDetails>, 256>;
+
+  constexpr std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+  constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
 
-  class ParseResult
+  // 64-bit FNV-1a, the hash used to look up option names.
+  inline
+  std::uint64_t
+  hash_name(StringView name) noexcept
+  {
+    std::uint64_t hash = FNV_OFFSET_BASIS;
+    for (char c : name)
+    {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= FNV_PRIME;
+    }
+    return hash;
+  }
+
+  // The same hash, in a form that can be evaluated at compile time.
+  constexpr
+  std::uint64_t
+  hash_name(const char* name, std::size_t size,
+    std::uint64_t hash = FNV_OFFSET_BASIS) noexcept
+  {
+    return size == 0
+      ? hash
+      : hash_name(name + 1, size - 1,
+          (hash ^ static_cast<unsigned char>(*name)) * FNV_PRIME);
+  }
+
+  // An option name together with its hash. Created from a string literal
+  // with key() or the _opt literal, the hash can be computed at compile
+  // time, so looking the key up in a ParseResult does not hash anything.
+  class OptionKey
   {
     public:
+    constexpr OptionKey(const char* name, std::size_t size) noexcept
+    : m_name(name, size)
+    , m_hash(hash_name(name, size))
+    {
+    }
 
-    ParseResult() = default;
-    ParseResult(const ParseResult&) = default;
+    CXXOPTS_NODISCARD
+    constexpr StringView
+    name() const noexcept
+    {
+      return m_name;
+    }
 
-    ParseResult(NameHashMap&& keys, ParsedHashMap&& values, std::vector<KeyValue> sequential, std::vector<std::string>&& unmatched_args)
-    : m_keys(std::move(keys))
-    , m_values(std::move(values))
-    , m_sequential(std::move(sequential))
-    , m_unmatched(std::move(unmatched_args))
+    CXXOPTS_NODISCARD
+    constexpr std::uint64_t
+    hash() const noexcept
     {
+      return m_hash;
     }
 
-    ParseResult& operator=(ParseResult&&) = default;
-    ParseResult& operator=(const ParseResult&) = default;
+    private:
+    StringView m_name;
+    std::uint64_t m_hash;
+  };
 
-    size_t
-    count(const std::string& o) const
+  template <std::size_t N>
+  constexpr
+  OptionKey
+  key(const char (&name)[N]) noexcept
+  {
+    return OptionKey(name, N - 1);
+  }
+
+  namespace literals
+  {
+    constexpr
+    OptionKey
+    operator"" _opt(const char* name, std::size_t size) noexcept
     {
-      auto iter = m_keys.find(o);
-      if (iter == m_keys.end())
-      {
-        return 0;
-      }
+      return OptionKey(name, size);
+    }
+  } // namespace literals
+
+  // A static index from every short and long option name to its details,
+  // built once for a fixed set of options. It is a perfect hash: names are
+  // split into small buckets, and each bucket has a seed that sends its
+  // names to slots that no other name uses. A lookup is one hash of the
+  // name, one seeded mix and one comparison.
+  class OptionIndex
+  {
+    public:
+    OptionIndex() = default;
+    OptionIndex(const OptionIndex&) = default;
+    OptionIndex(OptionIndex&&) = default;
 
-      auto viter = m_values.find(iter->second);
+    explicit OptionIndex(const OptionMap& options);
 
-      if (viter == m_values.end())
-      {
-        return 0;
-      }
+    OptionIndex& operator=(const OptionIndex&) = default;
+    OptionIndex& operator=(OptionIndex&&) = default;
 
-      return viter->second.count();
+    // The options the index was built from, which handles are checked
+    // against. It is only compared, never followed.
+    const void*
+    schema() const noexcept
+    {
+      return m_schema;
     }
 
-    const OptionValue&
-    operator[](const std::string& option) const
+    const std::shared_ptr<OptionDetails>*
+    find(StringView name) const noexcept
     {
-      auto iter = m_keys.find(option);
+      return find(name, hash_name(name));
+    }
 
-      if (iter == m_keys.end())
+    const std::shared_ptr<OptionDetails>*
+    find(StringView name, std::uint64_t hash) const noexcept
+    {
+      if (!m_sorted.empty())
       {
-        throw_or_mimic<option_not_present_exception>(option);
+        return find_sorted(name);
       }
 
-      auto viter = m_values.find(iter->second);
+      const auto seed = m_seeds[static_cast<size_t>(mix(hash, 0) & m_bucket_mask)];
+      const auto& slot = m_slots[static_cast<size_t>(mix(hash, seed) & m_slot_mask)];
+      return slot.details != nullptr && slot.name == name ? &slot.details : nullptr;
+    }
+
+    private:
+    struct Slot
+    {
+      Slot() = default;
 
-      if (viter == m_values.end())
+      Slot(StringView name_, std::shared_ptr<OptionDetails> details_)
+      : name(name_)
+      , details(std::move(details_))
       {
-        throw_or_mimic<option_not_present_exception>(option);
       }
 
-      return viter->second;
-    }
+      StringView name{};
+      std::shared_ptr<OptionDetails> details{};
+    };
 
-    const std::vector<KeyValue>&
-    arguments() const
+    static
+    std::uint64_t
+    mix(std::uint64_t hash, std::uint32_t seed) noexcept
     {
-      return m_sequential;
+      // the finaliser from MurmurHash3, applied to the seeded hash
+      hash ^= seed * 0x9e3779b97f4a7c15ull;
+      hash ^= hash >> 33;
+      hash *= 0xff51afd7ed558ccdull;
+      hash ^= hash >> 33;
+      return hash;
     }
 
-    const std::vector<std::string>&
-    unmatched() const
+    static
+    bool
+    name_less(StringView lhs, StringView rhs) noexcept
     {
-      return m_unmatched;
+      return std::lexicographical_compare(lhs.begin(), lhs.end(),
+        rhs.begin(), rhs.end());
     }
 
-    private:
-    NameHashMap m_keys{};
-    ParsedHashMap m_values{};
-    std::vector<KeyValue> m_sequential{};
-    std::vector<std::string> m_unmatched{};
-  };
+    bool
+    try_build(const std::vector<Slot>& names, size_t slot_count);
 
-  struct Option
-  {
-    Option
-    (
-      std::string opts,
-      std::string desc,
-      std::shared_ptr<const Value>  value = ::cxxopts::value<bool>(),
-      std::string arg_help = ""
-    )
-    : opts_(std::move(opts))
-    , desc_(std::move(desc))
-    , value_(std::move(value))
-    , arg_help_(std::move(arg_help))
+    const std::shared_ptr<OptionDetails>*
+    find_sorted(StringView name) const noexcept
     {
+      const auto slot = std::lower_bound(m_sorted.begin(), m_sorted.end(), name,
+        [](const Slot& lhs, StringView rhs) { return name_less(lhs.name, rhs); });
+      return slot != m_sorted.end() && slot->name == name ? &slot->details : nullptr;
     }
 
-    std::string opts_;
-    std::string desc_;
-    std::shared_ptr<const Value> value_;
-    std::string arg_help_;
+    // the names in order, searched instead of the perfect hash when no
+    // table could be built for them
+    std::vector<Slot> m_sorted{};
+    std::vector<Slot> m_slots = std::vector<Slot>(1);
+    std::vector<std::uint32_t> m_seeds = std::vector<std::uint32_t>(1);
+    std::uint64_t m_slot_mask = 0;
+    std::uint64_t m_bucket_mask = 0;
+    const void* m_schema = nullptr;
   };
 
-  using OptionMap = std::unordered_map<std::string, std::shared_ptr<OptionDetails>>;
-  using PositionalList = std::vector<std::string>;
-  using PositionalListIterator = PositionalList::const_iterator;
-
-  class OptionParser
+  inline
+  OptionIndex::OptionIndex(const OptionMap& options)
+  : m_schema(&options)
   {
-    public:
-    OptionParser(const OptionMap& options, const PositionalList& positional, bool allow_unrecognised)
-    : m_options(options)
-    , m_positional(positional)
-    , m_allow_unrecognised(allow_unrecognised)
+    // Point at the names held by the details, which the index keeps alive.
+    std::vector<Slot> names;
+    names.reserve(options.size());
+    for (const auto& option : options)
     {
+      const auto& details = option.second;
+      const std::string& name = option.first == details->short_name()
+        ? details->short_name()
+        : details->long_name();
+      names.emplace_back(name, details);
     }
 
-    ParseResult
-    parse(int argc, const char* const* argv);
+    size_t slot_count = 1;
+    while (slot_count < names.size())
+    {
+      slot_count <<= 1;
+    }
 
-    bool
-    consume_positional(const std::string& a, PositionalListIterator& next);
+    // This gives up on a table size only when it is very nearly full, and
+    // then a table twice as large succeeds at once. Names with the same
+    // 64-bit hash cannot be told apart by any table, so after a few larger
+    // tables fail the names are searched in order instead.
+    constexpr int max_doublings = 4;
+    for (int doublings = 0; !try_build(names, slot_count); ++doublings)
+    {
+      if (doublings == max_doublings)
+      {
+        m_slots.assign(1, Slot());
+        m_seeds.assign(1, 0);
+        m_slot_mask = 0;
+        m_bucket_mask = 0;
+
+        m_sorted = std::move(names);
+        std::sort(m_sorted.begin(), m_sorted.end(),
+          [](const Slot& lhs, const Slot& rhs) { return name_less(lhs.name, rhs.name); });
+        return;
+      }
+      slot_count <<= 1;
+    }
+  }
 
-    void
-    checked_parse_arg
-    (
-      int argc,
-      const char* const* argv,
-      int& current,
-      const std::shared_ptr<OptionDetails>& value,
-      const std::string& name
-    );
+  inline
+  bool
+  OptionIndex::try_build(const std::vector<Slot>& names, size_t slot_count)
+  {
+    const size_t bucket_count = slot_count > 1 ? slot_count / 2 : 1;
+    m_slot_mask = slot_count - 1;
+    m_bucket_mask = bucket_count - 1;
+
+    std::vector<std::uint64_t> hashes;
+    std::vector<std::vector<size_t>> buckets(bucket_count);
+    hashes.reserve(names.size());
+    for (size_t i = 0; i != names.size(); ++i)
+    {
+      hashes.push_back(hash_name(names[i].name));
+      buckets[static_cast<size_t>(mix(hashes[i], 0) & m_bucket_mask)].push_back(i);
+    }
 
-    void
-    add_to_option(OptionMap::const_iterator iter, const std::string& option, const std::string& arg);
+    // Place the largest buckets first, while there is the most room.
+    std::vector<size_t> order(bucket_count);
+    for (size_t i = 0; i != bucket_count; ++i)
+    {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&buckets](size_t a, size_t b) {
+      return buckets[a].size() > buckets[b].size();
+    });
 
-    void
-    parse_option
-    (
-      const std::shared_ptr<OptionDetails>& value,
-      const std::string& name,
-      const std::string& arg = ""
-    );
+    constexpr std::uint32_t max_seed = 1u << 16;
 
-    void
-    parse_default(const std::shared_ptr<OptionDetails>& details);
+    m_slots.assign(slot_count, Slot());
+    m_seeds.assign(bucket_count, 0);
+    std::vector<size_t> chosen;
+    for (size_t bucket : order)
+    {
+      const auto& members = buckets[bucket];
+      if (members.empty())
+      {
+        break;
+      }
 
-    void
-    parse_no_value(const std::shared_ptr<OptionDetails>& details);
+      std::uint32_t seed = 1;
+      for (; seed != max_seed; ++seed)
+      {
+        chosen.clear();
+        for (size_t member : members)
+        {
+          const auto slot = static_cast<size_t>(mix(hashes[member], seed) & m_slot_mask);
+          if (m_slots[slot].details != nullptr ||
+              std::find(chosen.begin(), chosen.end(), slot) != chosen.end())
+          {
+            break;
+          }
+          chosen.push_back(slot);
+        }
 
-    private:
+        if (chosen.size() == members.size())
+        {
+          break;
+        }
+      }
 
-    void finalise_aliases();
+      if (seed == max_seed)
+      {
+        return false;
+      }
 
-    const OptionMap& m_options;
-    const PositionalList& m_positional;
+      m_seeds[bucket] = seed;
+      for (size_t i = 0; i != members.size(); ++i)
+      {
+        m_slots[chosen[i]] = names[members[i]];
+      }
+    }
 
-    std::vector<KeyValue> m_sequential{};
-    bool m_allow_unrecognised;
+    return true;
+  }
 
-    ParsedHashMap m_parsed{};
-    NameHashMap m_keys{};
-  };
 
-  class Options
+  // The values from one parse, stored contiguously and indexed by option
+  // id. Names are resolved through the index of the options that produced
+  // the result, which the result shares.
+  class ParseResult
   {
     public:
 
-    explicit Options(std::string program, std::string help_string = "")
-    : m_program(std::move(program))
-    , m_help_string(toLocalString(std::move(help_string)))
-    , m_custom_help("[OPTION...]")
-    , m_positional_help("positional parameters")
-    , m_show_positional(false)
-    , m_allow_unrecognised(false)
-    , m_width(76)
-    , m_tab_expansion(false)
-    , m_options(std::make_shared<OptionMap>())
-    {
-    }
+    ParseResult() = default;
+    ParseResult(const ParseResult&) = default;
+    ParseResult(ParseResult&&) = default;
 
-    Options&
-    positional_help(std::string help_text)
+    ParseResult
+    (
+      std::shared_ptr<const OptionIndex> index,
+      std::vector<OptionValue>&& values,
+      std::vector<KeyValue> sequential,
+      std::vector<std::string>&& unmatched_args
+    )
+    : m_index(std::move(index))
+    , m_values(std::move(values))
+    , m_sequential(std::move(sequential))
+    , m_unmatched(std::move(unmatched_args))
     {
-      m_positional_help = std::move(help_text);
-      return *this;
     }
 
-    Options&
-    custom_help(std::string help_text)
+    // A sparse result, which only holds the options that were seen: values
+    // holds the options whose ids are in ids, which is sorted. Every other
+    // option reads its value, which is its default if it has one, from unset.
+    ParseResult
+    (
+      std::shared_ptr<const OptionIndex> index,
+      std::vector<std::size_t>&& ids,
+      std::vector<OptionValue>&& values,
+      std::shared_ptr<const std::vector<OptionValue>> unset,
+      std::vector<KeyValue> sequential,
+      std::vector<std::string>&& unmatched_args
+    )
+    : m_index(std::move(index))
+    , m_ids(std::move(ids))
+    , m_values(std::move(values))
+    , m_unset(std::move(unset))
+    , m_sequential(std::move(sequential))
+    , m_unmatched(std::move(unmatched_args))
     {
-      m_custom_help = std::move(help_text);
-      return *this;
     }
 
-    Options&
-    show_positional_help()
-    {
-      m_show_positional = true;
-      return *this;
-    }
+    ParseResult& operator=(ParseResult&&) = default;
+    ParseResult& operator=(const ParseResult&) = default;
 
-    Options&
-    allow_unrecognised_options()
+    size_t
+    count(StringView o) const
     {
-      m_allow_unrecognised = true;
-      return *this;
+      const auto* value = find(o);
+      return value == nullptr ? 0 : value->count();
     }
 
-    Options&
-    set_width(size_t width)
+    const OptionValue&
+    operator[](StringView option) const
     {
-      m_width = width;
-      return *this;
+      const auto* value = find(option);
+
+      if (value == nullptr)
+      {
+        throw_or_mimic<option_not_present_exception>(option.str());
+      }
+
+      return *value;
     }
 
-    Options&
-    set_tab_expansion(bool expansion=true)
+    size_t
+    count(const OptionKey& key) const
     {
-      m_tab_expansion = expansion;
-      return *this;
+      const auto* value = find(key.name(), key.hash());
+      return value == nullptr ? 0 : value->count();
     }
 
-    ParseResult
-    parse(int argc, const char* const* argv);
-
-    OptionAdder
-    add_options(std::string group = "");
+    const OptionValue&
+    operator[](const OptionKey& key) const
+    {
+      const auto* value = find(key.name(), key.hash());
 
-    void
-    add_options
-    (
-      const std::string& group,
-      std::initializer_list<Option> options
-    );
+      if (value == nullptr)
+      {
+        throw_or_mimic<option_not_present_exception>(key.name().str());
+      }
 
-    void
-    add_option
-    (
-      const std::string& group,
-      const Option& option
-    );
+      return *value;
+    }
 
-    void
-    add_option
-    (
-      const std::string& group,
-      const std::string& s,
-      const std::string& l,
-      std::string desc,
-      const std::shared_ptr<const Value>& value,
-      std::string arg_help
-    );
+    template <typename T>
+    size_t
+    count(const OptionHandle<T>& handle) const
+    {
+      const auto* value = find(handle);
+      return value == nullptr ? 0 : value->count();
+    }
 
-    //parse positional arguments into the given option
-    void
-    parse_positional(std::string option);
+    template <typename T>
+    const T&
+    get(const OptionHandle<T>& handle) const
+    {
+      const auto* value = find(handle);
 
-    void
-    parse_positional(std::vector<std::string> options);
+      if (value == nullptr)
+      {
+        throw_or_mimic<option_not_present_exception>(handle.name());
+      }
 
-    void
-    parse_positional(std::initializer_list<std::string> options);
+      return value->template get<T>();
+    }
 
-    template <typename Iterator>
+    // Converts every lazily converted value now, so that conversion errors
+    // are reported here instead of when a value is read.
     void
-    parse_positional(Iterator begin, Iterator end) {
-      parse_positional(std::vector<std::string>{begin, end});
+    validate() const
+    {
+      for (const auto& value : m_values)
+      {
+        value.validate();
+      }
     }
 
-    std::string
-    help(const std::vector<std::string>& groups = {}) const;
-
-    std::vector<std::string>
-    groups() const;
+    const std::vector<KeyValue>&
+    arguments() const
+    {
+      return m_sequential;
+    }
 
-    const HelpGroupDetails&
-    group_help(const std::string& group) const;
+    const std::vector<std::string>&
+    unmatched() const
+    {
+      return m_unmatched;
+    }
 
     private:
+    friend class ResultBuilder;
 
-    void
-    add_one_option
-    (
-      const std::string& option,
-      const std::shared_ptr<OptionDetails>& details
-    );
+    const OptionValue*
+    find(StringView name) const
+    {
+      return find(name, hash_name(name));
+    }
 
-    String
-    help_one_group(const std::string& group) const;
+    const OptionValue*
+    find(StringView name, std::uint64_t hash) const
+    {
+      if (m_index == nullptr)
+      {
+        return nullptr;
+      }
 
-    void
-    generate_group_help
-    (
-      String& result,
-      const std::vector<std::string>& groups
-    ) const;
+      const auto* details = m_index->find(name, hash);
+      return details == nullptr ? nullptr : find((*details)->id());
+    }
 
-    void
-    generate_all_groups_help(String& result) const;
+    const OptionValue*
+    find(std::size_t id) const
+    {
+      if (m_unset == nullptr)
+      {
+        return id < m_values.size() ? &m_values[id] : nullptr;
+      }
 
-    std::string m_program{};
-    String m_help_string{};
-    std::string m_custom_help{};
-    std::string m_positional_help{};
-    bool m_show_positional;
-    bool m_allow_unrecognised;
-    size_t m_width;
-    bool m_tab_expansion;
+      auto seen = std::lower_bound(m_ids.begin(), m_ids.end(), id);
+      if (seen != m_ids.end() && *seen == id)
+      {
+        return &m_values[static_cast<std::size_t>(seen - m_ids.begin())];
+      }
 
-    std::shared_ptr<OptionMap> m_options;
-    std::vector<std::string> m_positional{};
-    std::unordered_set<std::string> m_positional_set{};
+      return id < m_unset->size() ? &(*m_unset)[id] : nullptr;
+    }
 
-    //mapping from groups to help options
-    std::map<std::string, HelpGroupDetails> m_help{};
+    template <typename T>
+    const OptionValue*
+    find(const OptionHandle<T>& handle) const
+    {
+      if (handle.schema() != nullptr &&
+          (m_index == nullptr || handle.schema() != m_index->schema()))
+      {
+        return nullptr;
+      }
+
+      return find(handle.id());
+    }
 
-    std::list<OptionDetails> m_option_list{};
-    std::unordered_map<std::string, decltype(m_option_list)::iterator> m_option_map{};
+    std::shared_ptr<const OptionIndex> m_index{};
+    // only used by sparse results
+    std::vector<std::size_t> m_ids{};
+    std::vector<OptionValue> m_values{};
+    std::shared_ptr<const std::vector<OptionValue>> m_unset{};
+    std::vector<KeyValue> m_sequential{};
+    std::vector<std::string> m_unmatched{};
   };
 
-  class OptionAdder
+  struct Option
   {
-    public:
-
-    OptionAdder(Options& options, std::string group)
-    : m_options(options), m_group(std::move(group))
-    {
-    }
-
-    OptionAdder&
-    operator()
+    Option
     (
-      const std::string& opts,
-      const std::string& desc,
-      const std::shared_ptr<const Value>& value
-        = ::cxxopts::value<bool>(),
+      std::string opts,
+      std::string desc,
+      std::shared_ptr<const Value>  value = ::cxxopts::value<bool>(),
       std::string arg_help = ""
-    );
+    )
+    : opts_(std::move(opts))
+    , desc_(std::move(desc))
+    , value_(std::move(value))
+    , arg_help_(std::move(arg_help))
+    {
+    }
 
-    private:
-    Options& m_options;
-    std::string m_group;
+    std::string opts_;
+    std::string desc_;
+    std::shared_ptr<const Value> value_;
+    std::string arg_help_;
   };
 
-  namespace
+  using PositionalList = std::vector<std::string>;
+
+  // One thing that a parse found in the arguments, see Options::parse with a
+  // callback. The views refer to the arguments and to the options, and are
+  // only valid while both are.
+  class ParseEvent
   {
-    constexpr size_t OPTION_LONGEST = 30;
-    constexpr size_t OPTION_DESC_GAP = 2;
+    public:
+    enum class Kind : unsigned char
+    {
+      // an option given by name, with its value
+      Option,
+      // a positional argument, given to an option from parse_positional
+      Positional,
+      // an argument that nothing takes: a positional argument when there is
+      // no positional option left for it, or an unrecognised option
+      Unmatched,
+      // "--", after which every argument is positional
+      EndOfOptions,
+    };
 
-    String
-    format_option
+    ParseEvent() = default;
+
+    ParseEvent
     (
-      const HelpOptionDetails& o
+      Kind kind,
+      const std::shared_ptr<OptionDetails>* details,
+      StringView name,
+      StringView value,
+      bool implicit = false
     )
+    : m_details(details)
+    , m_name(name)
+    , m_value(value)
+    , m_kind(kind)
+    , m_implicit(implicit)
     {
-      const auto& s = o.s;
-      const auto& l = o.l;
-
-      String result = "  ";
+    }
 
-      if (!s.empty())
-      {
-        result += "-" + toLocalString(s);
-        if (!l.empty())
-        {
-          result += ",";
-        }
-      }
-      else
-      {
-        result += "   ";
-      }
+    CXXOPTS_NODISCARD
+    Kind
+    kind() const
+    {
+      return m_kind;
+    }
 
-      if (!l.empty())
-      {
-        result += " --" + toLocalString(l);
-      }
+    // The option, or nullptr for Unmatched and EndOfOptions.
+    CXXOPTS_NODISCARD
+    const OptionDetails*
+    option() const
+    {
+      return m_details == nullptr ? nullptr : m_details->get();
+    }
 
-      auto arg = !o.arg_help.empty() ? toLocalString(o.arg_help) : "arg";
+    // The option's id. Only valid when there is an option.
+    CXXOPTS_NODISCARD
+    std::size_t
+    id() const
+    {
+      return (*m_details)->id();
+    }
 
-      if (!o.is_boolean)
-      {
-        if (o.has_implicit)
-        {
-          result += " [=" + arg + "(=" + toLocalString(o.implicit_value) + ")]";
-        }
-        else
-        {
-          result += " " + arg;
-        }
-      }
+    // The name that the option was given by: the name as written for an
+    // Option, the name given to parse_positional for a Positional.
+    CXXOPTS_NODISCARD
+    StringView
+    name() const
+    {
+      return m_name;
+    }
 
-      return result;
+    // The option's value, or the whole argument for Unmatched.
+    CXXOPTS_NODISCARD
+    StringView
+    value() const
+    {
+      return m_value;
     }
 
-    String
-    format_description
+    // True if the option was given without a value and value() is its
+    // implicit value.
+    CXXOPTS_NODISCARD
+    bool
+    implicit() const
+    {
+      return m_implicit;
+    }
+
+    template <typename T>
+    T
+    as() const
+    {
+      T result;
+      values::parse_value(m_value.str(), result);
+      return result;
+    }
+
+    // The option, for sinks that store values. Only valid when there is an
+    // option.
+    const std::shared_ptr<OptionDetails>&
+    details() const
+    {
+      return *m_details;
+    }
+
+    private:
+    const std::shared_ptr<OptionDetails>* m_details = nullptr;
+    StringView m_name{};
+    StringView m_value{};
+    Kind m_kind = Kind::EndOfOptions;
+    bool m_implicit = false;
+  };
+
+  // The errors that a parse can find in the arguments.
+  enum class ParseError : unsigned char
+  {
+    None,
+    // starts with '-' but is not an option, see option_syntax_exception
+    Syntax,
+    // see option_not_exists_exception
+    UnknownOption,
+    // see missing_argument_exception
+    MissingArgument,
+    // see argument_incorrect_type
+    IncorrectType,
+    // a quote or backslash left open in a command string, see
+    // command_syntax_exception
+    Quoting,
+    // the number of kinds above, not an error
+    Count,
+  };
+
+  // A short description of a kind of error, such as "unknown option".
+  inline
+  const char*
+  parse_error_name(ParseError kind)
+  {
+    switch (kind)
+    {
+      case ParseError::None:
+        return "none";
+      case ParseError::Syntax:
+        return "syntax";
+      case ParseError::UnknownOption:
+        return "unknown option";
+      case ParseError::MissingArgument:
+        return "missing argument";
+      case ParseError::IncorrectType:
+        return "incorrect type";
+      case ParseError::Quoting:
+        return "quoting";
+      case ParseError::Count:
+        break;
+    }
+    return "";
+  }
+
+  // Receives the events of a parse, in the order of the arguments.
+  class ParseSink
+  {
+    public:
+    virtual ~ParseSink() = default;
+
+    virtual void
+    event(const ParseEvent& event) = 0;
+
+    // Reports an error in the arguments, by throwing its exception unless
+    // this is overridden. The parser gives up on the rest of the argument,
+    // so a sink that does not throw should not be fed any more of them.
+    virtual void
+    error(ParseError kind, const std::string& text)
+    {
+      switch (kind)
+      {
+        case ParseError::Syntax:
+          throw_or_mimic<option_syntax_exception>(text);
+          break;
+        case ParseError::UnknownOption:
+          throw_or_mimic<option_not_exists_exception>(text);
+          break;
+        case ParseError::MissingArgument:
+          throw_or_mimic<missing_argument_exception>(text);
+          break;
+        case ParseError::IncorrectType:
+          throw_or_mimic<argument_incorrect_type>(text);
+          break;
+        case ParseError::Quoting:
+          throw_or_mimic<command_syntax_exception>(text);
+          break;
+        case ParseError::None:
+        case ParseError::Count:
+          break;
+      }
+    }
+
+    // The number of times that an option has been given so far. A
+    // positional argument does not go to an option that was given by name.
+    virtual std::size_t
+    count(std::size_t id) const = 0;
+  };
+
+  // The outcome of CompiledOptions::validate.
+  class ValidationResult
+  {
+    public:
+    ValidationResult() = default;
+
+    ValidationResult(ParseError error, int index)
+    : m_index(index)
+    , m_error(error)
+    {
+    }
+
+    // True if the arguments are valid.
+    explicit operator bool() const
+    {
+      return m_error == ParseError::None;
+    }
+
+    CXXOPTS_NODISCARD
+    ParseError
+    error() const
+    {
+      return m_error;
+    }
+
+    // The index in argv of the argument with the first error, or 0 if there
+    // is none. A missing argument is reported at the option that needs it.
+    CXXOPTS_NODISCARD
+    int
+    index() const
+    {
+      return m_index;
+    }
+
+    private:
+    int m_index = 0;
+    ParseError m_error = ParseError::None;
+  };
+
+  class ParseEvents;
+  class IncrementalParser;
+  class ParseContext;
+
+  // A command line, in the form that main receives it.
+  struct CommandLine
+  {
+    int argc;
+    const char* const* argv;
+  };
+
+  // A command given as one string, split into arguments with the quoting of
+  // a POSIX shell. Words are separated by spaces, tabs and newlines. Text in
+  // single quotes is kept as it is. In double quotes a backslash only escapes
+  // $, `, ", \ and a newline. Elsewhere a backslash escapes any character,
+  // and a backslash before a newline removes both. Nothing is expanded, and
+  // '#' does not start a comment. The first word is the program name, as in
+  // argv. Every argument is kept in one buffer.
+  class CommandString
+  {
+    public:
+    explicit CommandString(StringView command)
+    {
+      if (!values::parser_tool::SplitCommand(command, m_buffer, m_argv))
+      {
+        throw_or_mimic<command_syntax_exception>(command.str());
+      }
+    }
+
+    // Moving keeps the buffer where it is, so argv stays valid; a copy would
+    // point into the original.
+    CommandString(CommandString&&) = default;
+    CommandString(const CommandString&) = delete;
+    CommandString& operator=(const CommandString&) = delete;
+
+    CXXOPTS_NODISCARD
+    int
+    argc() const
+    {
+      return static_cast<int>(m_argv.size());
+    }
+
+    CXXOPTS_NODISCARD
+    const char* const*
+    argv() const
+    {
+      return m_argv.data();
+    }
+
+    CXXOPTS_NODISCARD
+    CommandLine
+    command_line() const
+    {
+      return {argc(), argv()};
+    }
+
+    private:
+    std::vector<char> m_buffer{};
+    std::vector<const char*> m_argv{};
+  };
+
+#ifdef CXXOPTS_USE_BULK_PARSING
+  // How the command lines of a corpus are written, see
+  // CompiledOptions::analyse_corpus. In both, each line is a command line.
+  enum class CorpusFormat : unsigned char
+  {
+    // a command string, see CommandString
+    Shell,
+    // arguments each followed by a '\0', as in /proc/<pid>/cmdline, and
+    // a '\n' after the last one, so arguments cannot contain a newline
+    Cmdline,
+  };
+
+  // How options are used across the command lines of a corpus, see
+  // CompiledOptions::analyse_corpus. The counts of options are indexed by
+  // option id, and only include command lines without errors.
+  struct CorpusStats
+  {
+    explicit CorpusStats(std::size_t option_count = 0)
+    : uses(option_count)
+    , values(option_count)
+    , other_values(option_count)
+    {
+    }
+
+    // Adds the counts of another part of the corpus.
+    void
+    merge(const CorpusStats& other, std::size_t max_values);
+
+    // Counts `times` uses of a value of an option. Once an option has
+    // max_values distinct values, others are only counted in other_values.
+    void
+    count_value
     (
-      const HelpOptionDetails& o,
-      size_t start,
-      size_t allowed,
-      bool tab_expansion
-    )
+      std::size_t id,
+      const std::string& value,
+      std::size_t times,
+      std::size_t max_values
+    );
+
+    CXXOPTS_NODISCARD
+    std::size_t
+    error_count() const
+    {
+      std::size_t count = 0;
+      for (auto errors_of_kind : errors)
+      {
+        count += errors_of_kind;
+      }
+      return count;
+    }
+
+    // the command lines read, not counting empty lines
+    std::size_t commands = 0;
+    // the command lines with an error, indexed by ParseError
+    std::array<std::size_t, static_cast<std::size_t>(ParseError::Count)>
+      errors{};
+    // the arguments that no option took
+    std::size_t unmatched = 0;
+    // the number of times that each option was given
+    std::vector<std::size_t> uses;
+    // the number of times that each option was given each value, not
+    // counting implicit values
+    std::vector<std::unordered_map<std::string, std::size_t>> values;
+    // the number of times that each option was given a value that is not
+    // in values
+    std::vector<std::size_t> other_values;
+  };
+
+  // The outcome of parsing one command line of a batch.
+  struct BatchResult
+  {
+    ParseResult result{};
+    // set if the parse failed, in which case result is empty
+    std::exception_ptr error{};
+  };
+#endif
+
+  // An immutable set of options, created by Options::compile. Everything
+  // needed to parse is built once here, so parse is const and can be called
+  // from several threads at the same time. Options that are bound to a
+  // variable with value(&x) still write to that variable on every parse.
+  class CompiledOptions
+  {
+    public:
+    CompiledOptions
+    (
+      const OptionMap& options,
+      std::size_t option_count,
+      PositionalList positional,
+      bool allow_unrecognised,
+      bool sparse_results = false,
+      bool lazy_conversion = false
+    );
+
+    ParseResult
+    parse(int argc, const char* const* argv) const;
+
+    // Parses a command given as one string, see CommandString.
+    ParseResult
+    parse(StringView command) const
+    {
+      const CommandString arguments(command);
+      return parse(arguments.argc(), arguments.argv());
+    }
+
+    // Parses without storing anything: `callback` is called with each
+    // ParseEvent, in the order of the arguments. Defaults are not reported.
+    template <typename Callback>
+    void
+    parse(int argc, const char* const* argv, Callback&& callback) const;
+
+    // Parses as the events are read, one argument at a time, so reading can
+    // stop before the end of the arguments.
+    ParseEvents
+    events(int argc, const char* const* argv) const;
+
+    // A parser that is given the arguments one at a time.
+    IncrementalParser
+    incremental() const;
+
+    // A context for parsing many times, which reuses the storage of its
+    // result.
+    ParseContext
+    context() const;
+
+    // Checks the arguments as parse would, converting each value but
+    // keeping none of them, and reports the first error instead of throwing
+    // it. Nothing is written to options bound to a variable.
+    ValidationResult
+    validate(int argc, const char* const* argv) const;
+
+#ifdef CXXOPTS_USE_BULK_PARSING
+    // Parses each command line on `workers` threads, or one per hardware
+    // thread if it is 0, and returns the results in the same order. An
+    // error is kept in the command line's BatchResult instead of being
+    // thrown. Options bound to a variable must not be used, since every
+    // thread would write to it. Needs the threads library to be linked.
+    std::vector<BatchResult>
+    parse_batch
+    (
+      const CommandLine* lines,
+      std::size_t count,
+      unsigned workers = 0
+    ) const;
+
+    // As above, for a vector of command lines.
+    std::vector<BatchResult>
+    parse_batch
+    (
+      const std::vector<CommandLine>& lines,
+      unsigned workers = 0
+    ) const
+    {
+      return parse_batch(lines.data(), lines.size(), workers);
+    }
+
+    // Counts the options and values of every command line in `corpus`, one
+    // per line, on `workers` threads or one per hardware thread. Each
+    // command line is checked as by validate, and errors are counted rather
+    // than thrown. Up to max_values distinct values are kept for each
+    // option. Needs the threads library to be linked.
+    CorpusStats
+    analyse_corpus
+    (
+      StringView corpus,
+      CorpusFormat format,
+      unsigned workers = 0,
+      std::size_t max_values = 1000
+    ) const;
+#endif
+
+    // The option with the given id, or nullptr if it has no names.
+    CXXOPTS_NODISCARD
+    const OptionDetails*
+    option(std::size_t id) const
+    {
+      return id < m_details.size() ? m_details[id].get() : nullptr;
+    }
+
+    std::size_t
+    option_count() const
+    {
+      return m_details.size();
+    }
+
+    private:
+    friend class OptionParser;
+    friend class ResultBuilder;
+    friend class ParseEvents;
+    friend class CountingSink;
+
+    // A name from parse_positional, resolved when compiling.
+    struct Positional
+    {
+      Positional(std::string name_, std::shared_ptr<OptionDetails> details_)
+      : name(std::move(name_))
+      , details(std::move(details_))
+      , is_container(details != nullptr && details->value().is_container())
+      {
+      }
+
+      std::string name;
+      // null if there is no option with this name
+      std::shared_ptr<OptionDetails> details;
+      // takes every remaining positional argument, otherwise takes one
+      bool is_container;
+    };
+
+    std::shared_ptr<const OptionIndex> m_index;
+    // indexed by option id
+    std::vector<std::shared_ptr<OptionDetails>> m_details;
+    ShortOptionTable m_short_options{};
+    std::vector<Positional> m_positional{};
+    // the text of each option's implicit value, by id
+    std::vector<std::string> m_implicit{};
+    bool m_allow_unrecognised;
+    bool m_lazy_conversion;
+
+    // Set for sparse results: the value of every option that is not given,
+    // by id. Options bound to a variable that have a default are listed in
+    // m_bound_defaults instead, since every parse writes their default.
+    std::shared_ptr<const std::vector<OptionValue>> m_unset{};
+    std::vector<std::shared_ptr<OptionDetails>> m_bound_defaults{};
+  };
+
+  // The parser. It takes the arguments one at a time, keeping what it needs
+  // between them, and reports what it finds to a ParseSink.
+  class OptionParser
+  {
+    public:
+    explicit OptionParser(const CompiledOptions& schema)
+    : m_schema(&schema)
+    {
+    }
+
+    OptionParser(const OptionParser&) = default;
+    OptionParser& operator=(const OptionParser&) = default;
+
+    // Parses the next argument. argv[0] is not an argument.
+    void
+    feed(StringView argument, ParseSink& sink);
+
+    // Ends the arguments. This fails if an option is still waiting for its
+    // value.
+    void
+    finish(ParseSink& sink);
+
+    // Forgets everything about the arguments so far.
+    void
+    reset();
+
+    // True if the last argument was an option that takes the next argument
+    // as its value.
+    CXXOPTS_NODISCARD
+    bool
+    pending() const
+    {
+      return m_pending != nullptr;
+    }
+
+    private:
+    void
+    parse_option_name
+    (
+      const values::parser_tool::ArguDesc& argu_desc,
+      ParseSink& sink
+    );
+
+    void
+    parse_short_group
+    (
+      const values::parser_tool::ArguDesc& argu_desc,
+      ParseSink& sink
+    );
+
+    bool
+    consume_positional(StringView a, ParseSink& sink);
+
+    // An option given without a value, which takes its implicit value or
+    // else the next argument.
+    void
+    checked_parse_arg
+    (
+      const std::shared_ptr<OptionDetails>& details,
+      StringView name,
+      ParseSink& sink
+    );
+
+    const CompiledOptions* m_schema;
+    const std::shared_ptr<OptionDetails>* m_pending = nullptr;
+    std::string m_pending_name{};
+    std::size_t m_next_positional = 0;
+    bool m_end_of_options = false;
+  };
+
+  // Stores the events of a parse in a ParseResult.
+  class ResultBuilder : public ParseSink
+  {
+    public:
+    explicit ResultBuilder(const CompiledOptions& schema)
+    : m_schema(schema)
+    , m_parsed(schema.m_unset == nullptr ? schema.option_count() : 0)
+    {
+    }
+
+    void
+    event(const ParseEvent& event) override;
+
+    std::size_t
+    count(std::size_t id) const override;
+
+    // Adds the defaults of the options that were not given, and returns the
+    // result.
+    ParseResult
+    result();
+
+    // Starts a new result, after result() or to discard the events so far.
+    // The strings and values of the last result are kept to be reused.
+    void
+    reset();
+
+    // Takes back the storage of a result that this builder returned, and
+    // starts a new result in it.
+    void
+    recycle(ParseResult& result);
+
+    private:
+    // The value of an option, which is added to a sparse result the first
+    // time that it is needed.
+    OptionValue&
+    store(std::size_t id);
+
+    const CompiledOptions& m_schema;
+
+    std::vector<KeyValue> m_sequential{};
+    // for sparse results, the sorted ids of the values in m_parsed
+    std::vector<std::size_t> m_ids{};
+    std::vector<OptionValue> m_parsed;
+    std::vector<std::string> m_unmatched{};
+
+    // the strings of earlier results, whose storage is reused
+    std::vector<KeyValue> m_spare_sequential{};
+    std::vector<std::string> m_spare_unmatched{};
+  };
+
+  // A sink that only counts the options that it is given, which is all the
+  // parser needs from a sink to place positional arguments.
+  class CountingSink : public ParseSink
+  {
+    public:
+    explicit CountingSink(const CompiledOptions& schema)
+    // only needed to place positional arguments
+    : m_counts(schema.m_positional.empty() ? 0 : schema.option_count())
+    {
+    }
+
+    std::size_t
+    count(std::size_t id) const override
+    {
+      return m_counts.empty() ? 0 : m_counts[id];
+    }
+
+    protected:
+    void
+    counted(const ParseEvent& event)
+    {
+      if (!m_counts.empty() && event.option() != nullptr)
+      {
+        ++m_counts[event.id()];
+      }
+    }
+
+    void
+    reset_counts()
+    {
+      std::fill(m_counts.begin(), m_counts.end(), 0);
+    }
+
+    private:
+    std::vector<std::size_t> m_counts;
+  };
+
+  template <typename Callback>
+  class CallbackSink : public CountingSink
+  {
+    public:
+    CallbackSink(const CompiledOptions& schema, Callback& callback)
+    : CountingSink(schema)
+    , m_callback(callback)
+    {
+    }
+
+    void
+    event(const ParseEvent& event) override
+    {
+      counted(event);
+      m_callback(event);
+    }
+
+    private:
+    Callback& m_callback;
+  };
+
+  // Checks the events of a parse, converting each value into a temporary
+  // that is thrown away, and keeps the first error instead of throwing it.
+  class ValidatingSink : public CountingSink
+  {
+    public:
+    explicit ValidatingSink(const CompiledOptions& schema)
+    : CountingSink(schema)
+    {
+    }
+
+    void
+    event(const ParseEvent& event) override;
+
+    void
+    error(ParseError kind, const std::string& /*text*/) override
+    {
+      if (m_error == ParseError::None)
+      {
+        m_error = kind;
+      }
+    }
+
+    CXXOPTS_NODISCARD
+    ParseError
+    first_error() const
+    {
+      return m_error;
+    }
+
+    // Starts on the arguments of another parse.
+    void
+    reset()
+    {
+      reset_counts();
+      m_error = ParseError::None;
+    }
+
+    private:
+    // reused for the text of each value
+    std::string m_text{};
+    ParseError m_error = ParseError::None;
+  };
+
+#ifdef CXXOPTS_USE_BULK_PARSING
+  // Counts the options and values of the command lines in a corpus, for one
+  // thread of CompiledOptions::analyse_corpus. The events of a command line
+  // are only counted once it has been read without an error.
+  class CorpusSink : public ValidatingSink
+  {
+    public:
+    CorpusSink
+    (
+      const CompiledOptions& schema,
+      CorpusStats& stats,
+      std::size_t max_values
+    )
+    : ValidatingSink(schema)
+    , m_stats(stats)
+    , m_max_values(max_values)
+    {
+    }
+
+    void
+    event(const ParseEvent& event) override;
+
+    // Counts the events of the command line, or its error.
+    void
+    finish_command();
+
+    void
+    start_command()
+    {
+      reset();
+      m_events.clear();
+      m_unmatched = 0;
+    }
+
+    private:
+    CorpusStats& m_stats;
+    std::size_t m_max_values;
+    struct Given
+    {
+      std::size_t id;
+      StringView value;
+      bool implicit;
+    };
+
+    // the options of the current command line, and their values
+    std::vector<Given> m_events{};
+    std::size_t m_unmatched = 0;
+    // reused for each value that is looked up
+    std::string m_key{};
+  };
+#endif
+
+  // The events of a parse, found one argument at a time as they are read,
+  // see CompiledOptions::events. An event is valid until the iterator is
+  // advanced. Errors are thrown by begin() or by advancing the iterator.
+  class ParseEvents
+  {
+    public:
+    class iterator
+    {
+      public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type = ParseEvent;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const ParseEvent*;
+      using reference = const ParseEvent&;
+
+      iterator() = default;
+
+      explicit iterator(ParseEvents* events)
+      : m_events(events)
+      {
+      }
+
+      reference
+      operator*() const
+      {
+        return m_events->current();
+      }
+
+      pointer
+      operator->() const
+      {
+        return &m_events->current();
+      }
+
+      iterator&
+      operator++()
+      {
+        m_events->next();
+        return *this;
+      }
+
+      iterator
+      operator++(int)
+      {
+        iterator previous = *this;
+        m_events->next();
+        return previous;
+      }
+
+      bool
+      operator==(const iterator& other) const
+      {
+        return at_end() == other.at_end();
+      }
+
+      bool
+      operator!=(const iterator& other) const
+      {
+        return !(*this == other);
+      }
+
+      private:
+      bool
+      at_end() const
+      {
+        return m_events == nullptr || m_events->at_end();
+      }
+
+      ParseEvents* m_events = nullptr;
+    };
+
+    ParseEvents
+    (
+      const CompiledOptions& schema,
+      int argc,
+      const char* const* argv,
+      std::shared_ptr<const CompiledOptions> owner = nullptr
+    );
+
+    ParseEvents(ParseEvents&&) = default;
+    ParseEvents(const ParseEvents&) = delete;
+    ParseEvents& operator=(const ParseEvents&) = delete;
+
+    // Reads arguments until the first event.
+    iterator
+    begin();
+
+    iterator
+    end()
+    {
+      return iterator();
+    }
+
+    // The index in argv of the argument that the current event came from.
+    // The arguments after it have not been read.
+    CXXOPTS_NODISCARD
+    int
+    argument_index() const
+    {
+      return m_next - 1;
+    }
+
+    private:
+    // Keeps the events of one argument, which may be several for a group
+    // of short options.
+    class Buffer : public CountingSink
+    {
+      public:
+      explicit Buffer(const CompiledOptions& schema)
+      : CountingSink(schema)
+      {
+      }
+
+      void
+      event(const ParseEvent& event) override
+      {
+        counted(event);
+        m_events.push_back(event);
+      }
+
+      std::vector<ParseEvent> m_events{};
+    };
+
+    const ParseEvent&
+    current() const
+    {
+      return m_buffer.m_events[m_position];
+    }
+
+    bool
+    at_end() const
+    {
+      return m_position == m_buffer.m_events.size();
+    }
+
+    void
+    next();
+
+    // Reads arguments until one of them has events, or they run out.
+    void
+    fill();
+
+    std::shared_ptr<const CompiledOptions> m_owner;
+    OptionParser m_parser;
+    Buffer m_buffer;
+    const char* const* m_argv;
+    int m_argc;
+    int m_next = 1;
+    std::size_t m_position = 0;
+    bool m_started = false;
+    bool m_finished = false;
+  };
+
+  // Parses arguments that arrive one at a time, for example from a socket,
+  // into a ParseResult. Each argument is copied where it is kept, so it only
+  // needs to be valid during the call to feed. After an error, reset() must
+  // be called before the parser is used again.
+  class IncrementalParser
+  {
+    public:
+    explicit IncrementalParser
+    (
+      const CompiledOptions& schema,
+      std::shared_ptr<const CompiledOptions> owner = nullptr
+    )
+    : m_owner(std::move(owner))
+    , m_parser(schema)
+    , m_builder(schema)
+    {
+    }
+
+    // Parses the next argument. The first argument is not the program name.
+    void
+    feed(StringView argument)
+    {
+      m_parser.feed(argument, m_builder);
+    }
+
+    // True if the last argument was an option that is waiting for its value.
+    CXXOPTS_NODISCARD
+    bool
+    pending() const
+    {
+      return m_parser.pending();
+    }
+
+    // Ends the arguments and returns the result. The parser is then ready
+    // for the arguments of another parse.
+    ParseResult
+    finish();
+
+    // Discards the arguments given so far.
+    void
+    reset()
+    {
+      m_parser.reset();
+      m_builder.reset();
+    }
+
+    private:
+    std::shared_ptr<const CompiledOptions> m_owner;
+    OptionParser m_parser;
+    ResultBuilder m_builder;
+  };
+
+  // Parses many times into one result, whose strings, values and lists are
+  // kept and reused. Once they have grown to fit the arguments, a parse into
+  // a dense result allocates nothing, unless a value does when it is
+  // converted. Lazily converted values are still allocated on every parse.
+  class ParseContext
+  {
+    public:
+    explicit ParseContext
+    (
+      const CompiledOptions& schema,
+      std::shared_ptr<const CompiledOptions> owner = nullptr
+    )
+    : m_owner(std::move(owner))
+    , m_parser(schema)
+    , m_builder(schema)
+    {
+    }
+
+    // Parses into the context's result, which stays valid until the next
+    // parse or reset. Copy it to keep it longer.
+    const ParseResult&
+    parse(int argc, const char* const* argv);
+
+    // The result of the last parse.
+    CXXOPTS_NODISCARD
+    const ParseResult&
+    result() const
+    {
+      return m_result;
+    }
+
+    // Empties the result, keeping its storage.
+    void
+    reset()
+    {
+      m_builder.recycle(m_result);
+      m_parser.reset();
+    }
+
+    private:
+    std::shared_ptr<const CompiledOptions> m_owner;
+    OptionParser m_parser;
+    ResultBuilder m_builder;
+    ParseResult m_result{};
+  };
+
+  // Keeps the results of the most recent distinct parses, up to a capacity,
+  // and returns a kept result when the same arguments are parsed again. The
+  // arguments are found by a hash of their bytes, and compared in full
+  // before a kept result is returned. The program name is not compared.
+  // Options bound to a variable are only written when the arguments are not
+  // in the cache. A cache can be used from several threads at once.
+  class ParseCache
+  {
+    public:
+    ParseCache(const CompiledOptions& schema, std::size_t capacity)
+    : m_schema(&schema)
+    , m_capacity(capacity)
+    {
+    }
+
+    ParseCache
+    (
+      std::shared_ptr<const CompiledOptions> schema,
+      std::size_t capacity
+    )
+    : m_owner(std::move(schema))
+    , m_schema(m_owner.get())
+    , m_capacity(capacity)
+    {
+    }
+
+    ParseCache(const ParseCache&) = delete;
+    ParseCache& operator=(const ParseCache&) = delete;
+
+    // The result of parsing the arguments, which is shared with the cache
+    // and with any other caller that parsed the same arguments. Errors are
+    // thrown, and not kept.
+    std::shared_ptr<const ParseResult>
+    parse(int argc, const char* const* argv);
+
+    // Forgets every kept result, and resets the counts.
+    void
+    clear();
+
+    CXXOPTS_NODISCARD
+    std::size_t
+    capacity() const
+    {
+      return m_capacity;
+    }
+
+    CXXOPTS_NODISCARD
+    std::size_t
+    size() const;
+
+    // The number of parses that were answered from the cache.
+    CXXOPTS_NODISCARD
+    std::size_t
+    hits() const;
+
+    // The number of parses that were not, including any that failed.
+    CXXOPTS_NODISCARD
+    std::size_t
+    misses() const;
+
+    private:
+    struct Entry
+    {
+      std::uint64_t hash;
+      // each argument after the program name, followed by its '\0'
+      std::string arguments;
+      std::shared_ptr<const ParseResult> result;
+    };
+
+    // Hashes the arguments with their terminators, and adds up their size.
+    static
+    std::uint64_t
+    hash_arguments(int argc, const char* const* argv, std::size_t& size);
+
+    static
+    bool
+    same_arguments
+    (
+      const std::string& arguments,
+      int argc,
+      const char* const* argv
+    );
+
+    std::shared_ptr<const CompiledOptions> m_owner{};
+    const CompiledOptions* m_schema;
+    std::size_t m_capacity;
+
+    mutable std::mutex m_mutex{};
+    // the most recently used first
+    std::list<Entry> m_entries{};
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> m_index{};
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+  };
+
+  class Options
+  {
+    public:
+
+    explicit Options(std::string program, std::string help_string = "")
+    : m_program(std::move(program))
+    , m_help_string(toLocalString(std::move(help_string)))
+    , m_custom_help("[OPTION...]")
+    , m_positional_help("positional parameters")
+    , m_show_positional(false)
+    , m_allow_unrecognised(false)
+    , m_width(76)
+    , m_tab_expansion(false)
+    , m_options(std::make_shared<OptionMap>())
+    {
+    }
+
+    Options&
+    positional_help(std::string help_text)
+    {
+      m_positional_help = std::move(help_text);
+      return *this;
+    }
+
+    Options&
+    custom_help(std::string help_text)
+    {
+      m_custom_help = std::move(help_text);
+      return *this;
+    }
+
+    Options&
+    show_positional_help()
+    {
+      m_show_positional = true;
+      return *this;
+    }
+
+    Options&
+    allow_unrecognised_options()
+    {
+      m_allow_unrecognised = true;
+      m_compiled.reset();
+      return *this;
+    }
+
+    Options&
+    set_width(size_t width)
+    {
+      m_width = width;
+      return *this;
+    }
+
+    Options&
+    set_tab_expansion(bool expansion=true)
+    {
+      m_tab_expansion = expansion;
+      return *this;
+    }
+
+    // Sparse results only store the options that are given, and read the
+    // default of any other option from the compiled options, so the cost of
+    // a parse does not grow with the number of options.
+    Options&
+    set_sparse_results(bool sparse=true)
+    {
+      m_sparse_results = sparse;
+      m_compiled.reset();
+      return *this;
+    }
+
+    // Lazy conversion keeps the text of each option and converts it when the
+    // value is first read, or by ParseResult::validate. Options bound to a
+    // variable are always converted during the parse.
+    Options&
+    set_lazy_conversion(bool lazy=true)
+    {
+      m_lazy_conversion = lazy;
+      m_compiled.reset();
+      return *this;
+    }
+
+    ParseResult
+    parse(int argc, const char* const* argv);
+
+    // See CompiledOptions::parse with a command string.
+    ParseResult
+    parse(StringView command);
+
+    // Calls `callback` with each ParseEvent instead of storing the values,
+    // see CompiledOptions::parse.
+    template <typename Callback>
+    void
+    parse(int argc, const char* const* argv, Callback&& callback);
+
+    // See CompiledOptions::events. The events keep the compiled options that
+    // they use, so these options may be changed while they are read.
+    ParseEvents
+    events(int argc, const char* const* argv);
+
+    // See CompiledOptions::incremental. The parser keeps the compiled options
+    // that it uses.
+    IncrementalParser
+    incremental();
+
+    // See CompiledOptions::context. The context keeps the compiled options
+    // that it uses.
+    ParseContext
+    context();
+
+    // See CompiledOptions::validate.
+    ValidationResult
+    validate(int argc, const char* const* argv);
+
+#ifdef CXXOPTS_USE_BULK_PARSING
+    // See CompiledOptions::parse_batch.
+    std::vector<BatchResult>
+    parse_batch
+    (
+      const std::vector<CommandLine>& lines,
+      unsigned workers = 0
+    );
+
+    // See CompiledOptions::analyse_corpus.
+    CorpusStats
+    analyse_corpus
+    (
+      StringView corpus,
+      CorpusFormat format,
+      unsigned workers = 0,
+      std::size_t max_values = 1000
+    );
+#endif
+
+    // Builds an immutable copy of the options for parsing. Later changes to
+    // these options do not affect it.
+    CompiledOptions
+    compile() const;
+
+    // The compiled copy that parse uses, which is built again after these
+    // options change.
+    std::shared_ptr<const CompiledOptions>
+    compiled();
+
+    OptionAdder
+    add_options(std::string group = "");
+
+    void
+    add_options
+    (
+      const std::string& group,
+      std::initializer_list<Option> options
+    );
+
+    void
+    add_option
+    (
+      const std::string& group,
+      const Option& option
+    );
+
+    // Returns the id of the new option.
+    std::size_t
+    add_option
+    (
+      const std::string& group,
+      const std::string& s,
+      const std::string& l,
+      std::string desc,
+      const std::shared_ptr<const Value>& value,
+      std::string arg_help
+    );
+
+    //parse positional arguments into the given option
+    void
+    parse_positional(std::string option);
+
+    void
+    parse_positional(std::vector<std::string> options);
+
+    void
+    parse_positional(std::initializer_list<std::string> options);
+
+    template <typename Iterator>
+    void
+    parse_positional(Iterator begin, Iterator end) {
+      parse_positional(std::vector<std::string>{begin, end});
+    }
+
+    std::string
+    help(const std::vector<std::string>& groups = {}) const;
+
+    std::vector<std::string>
+    groups() const;
+
+    const HelpGroupDetails&
+    group_help(const std::string& group) const;
+
+    private:
+    friend class OptionAdder;
+
+    void
+    add_one_option
+    (
+      const std::string& option,
+      const std::shared_ptr<OptionDetails>& details
+    );
+
+    String
+    help_one_group(const std::string& group) const;
+
+    void
+    generate_group_help
+    (
+      String& result,
+      const std::vector<std::string>& groups
+    ) const;
+
+    void
+    generate_all_groups_help(String& result) const;
+
+    std::string m_program{};
+    String m_help_string{};
+    std::string m_custom_help{};
+    std::string m_positional_help{};
+    bool m_show_positional;
+    bool m_allow_unrecognised;
+    size_t m_width;
+    bool m_tab_expansion;
+    bool m_sparse_results = false;
+    bool m_lazy_conversion = false;
+
+    // The names here are only looked up while options are added and help is
+    // written. Parsing and reading results go through the CompiledOptions
+    // index, which takes a StringView.
+    std::shared_ptr<OptionMap> m_options;
+    // compiled on the first parse after the options change
+    std::shared_ptr<const CompiledOptions> m_compiled{};
+    std::size_t m_next_id = 0;
+    std::vector<std::string> m_positional{};
+    std::unordered_set<std::string> m_positional_set{};
+
+    //mapping from groups to help options
+    std::map<std::string, HelpGroupDetails> m_help{};
+  };
+
+  class OptionAdder
+  {
+    public:
+
+    OptionAdder(Options& options, std::string group)
+    : m_options(options), m_group(std::move(group))
+    {
+    }
+
+    OptionAdder&
+    operator()
+    (
+      const std::string& opts,
+      const std::string& desc,
+      const std::shared_ptr<const Value>& value
+        = ::cxxopts::value<bool>(),
+      std::string arg_help = ""
+    );
+
+    // Adds an option like operator(), and returns a handle for reading its
+    // value from a ParseResult without looking up its name. The value must
+    // hold a T.
+    template <typename T>
+    OptionHandle<T>
+    add
+    (
+      const std::string& opts,
+      const std::string& desc,
+      const std::shared_ptr<const Value>& value = ::cxxopts::value<T>(),
+      std::string arg_help = ""
+    )
+    {
+      if (value->type() != values::type_id<T>())
+      {
+        throw_or_mimic<invalid_option_type_error>(opts);
+      }
+
+      std::string name;
+      const auto id = add_option(opts, desc, value, std::move(arg_help), name);
+      return OptionHandle<T>(id, std::move(name), m_options.m_options.get());
+    }
+
+    private:
+    // Returns the id of the option, and sets name to its long name, or to
+    // its short name if it has no long name.
+    std::size_t
+    add_option
+    (
+      const std::string& opts,
+      const std::string& desc,
+      const std::shared_ptr<const Value>& value,
+      std::string arg_help,
+      std::string& name
+    );
+
+    Options& m_options;
+    std::string m_group;
+  };
+
+  namespace
+  {
+    constexpr size_t OPTION_LONGEST = 30;
+    constexpr size_t OPTION_DESC_GAP = 2;
+
+    String
+    format_option
+    (
+      const HelpOptionDetails& o
+    )
+    {
+      const auto& s = o.s;
+      const auto& l = o.l;
+
+      String result = "  ";
+
+      if (!s.empty())
+      {
+        result += "-" + toLocalString(s);
+        if (!l.empty())
+        {
+          result += ",";
+        }
+      }
+      else
+      {
+        result += "   ";
+      }
+
+      if (!l.empty())
+      {
+        result += " --" + toLocalString(l);
+      }
+
+      auto arg = !o.arg_help.empty() ? toLocalString(o.arg_help) : "arg";
+
+      if (!o.is_boolean)
+      {
+        if (o.has_implicit)
+        {
+          result += " [=" + arg + "(=" + toLocalString(o.implicit_value) + ")]";
+        }
+        else
+        {
+          result += " " + arg;
+        }
+      }
+
+      return result;
+    }
+
+    String
+    format_description
+    (
+      const HelpOptionDetails& o,
+      size_t start,
+      size_t allowed,
+      bool tab_expansion
+    )
+    {
+      auto desc = o.desc;
+
+      if (o.has_default && (!o.is_boolean || o.default_value != "false"))
+      {
+        if(!o.default_value.empty())
+        {
+          desc += toLocalString(" (default: " + o.default_value + ")");
+        }
+        else
+        {
+          desc += toLocalString(" (default: \"\")");
+        }
+      }
+
+      String result;
+
+      if (tab_expansion)
+      {
+        String desc2;
+        auto size = size_t{ 0 };
+        for (auto c = std::begin(desc); c != std::end(desc); ++c)
+        {
+          if (*c == '\n')
+          {
+            desc2 += *c;
+            size = 0;
+          }
+          else if (*c == '\t')
+          {
+            auto skip = 8 - size % 8;
+            stringAppend(desc2, skip, ' ');
+            size += skip;
+          }
+          else
+          {
+            desc2 += *c;
+            ++size;
+          }
+        }
+        desc = desc2;
+      }
+
+      desc += " ";
+
+      auto current = std::begin(desc);
+      auto previous = current;
+      auto startLine = current;
+      auto lastSpace = current;
+
+      auto size = size_t{};
+
+      bool appendNewLine;
+      bool onlyWhiteSpace = true;
+
+      while (current != std::end(desc))
+      {
+        appendNewLine = false;
+
+        if (std::isblank(*previous))
+        {
+          lastSpace = current;
+        }
+
+        if (!std::isblank(*current))
+        {
+          onlyWhiteSpace = false;
+        }
+
+        while (*current == '\n')
+        {
+          previous = current;
+          ++current;
+          appendNewLine = true;
+        }
+
+        if (!appendNewLine && size >= allowed)
+        {
+          if (lastSpace != startLine)
+          {
+            current = lastSpace;
+            previous = current;
+          }
+          appendNewLine = true;
+        }
+
+        if (appendNewLine)
+        {
+          stringAppend(result, startLine, current);
+          startLine = current;
+          lastSpace = current;
+
+          if (*previous != '\n')
+          {
+            stringAppend(result, "\n");
+          }
+
+          stringAppend(result, start, ' ');
+
+          if (*previous != '\n')
+          {
+            stringAppend(result, lastSpace, current);
+          }
+
+          onlyWhiteSpace = true;
+          size = 0;
+        }
+
+        previous = current;
+        ++current;
+        ++size;
+      }
+
+      //append whatever is left but ignore whitespace
+      if (!onlyWhiteSpace)
+      {
+        stringAppend(result, startLine, previous);
+      }
+
+      return result;
+    }
+  } // namespace
+
+inline
+void
+Options::add_options
+(
+  const std::string &group,
+  std::initializer_list<Option> options
+)
+{
+ OptionAdder option_adder(*this, group);
+ for (const auto &option: options)
+ {
+   option_adder(option.opts_, option.desc_, option.value_, option.arg_help_);
+ }
+}
+
+inline
+OptionAdder
+Options::add_options(std::string group)
+{
+  return OptionAdder(*this, std::move(group));
+}
+
+inline
+OptionAdder&
+OptionAdder::operator()
+(
+  const std::string& opts,
+  const std::string& desc,
+  const std::shared_ptr<const Value>& value,
+  std::string arg_help
+)
+{
+  std::string name;
+  add_option(opts, desc, value, std::move(arg_help), name);
+  return *this;
+}
+
+inline
+std::size_t
+OptionAdder::add_option
+(
+  const std::string& opts,
+  const std::string& desc,
+  const std::shared_ptr<const Value>& value,
+  std::string arg_help,
+  std::string& name
+)
+{
+  std::string short_sw, long_sw;
+  std::tie(short_sw, long_sw) = values::parser_tool::SplitSwitchDef(opts);
+
+  if (!short_sw.length() && !long_sw.length())
+  {
+    throw_or_mimic<invalid_option_format_error>(opts);
+  }
+  else if (long_sw.length() == 1 && short_sw.length())
+  {
+    throw_or_mimic<invalid_option_format_error>(opts);
+  }
+
+  auto option_names = []
+  (
+    const std::string &short_,
+    const std::string &long_
+  )
+  {
+    if (long_.length() == 1)
+    {
+      return std::make_tuple(long_, short_);
+    }
+    return std::make_tuple(short_, long_);
+  }(short_sw, long_sw);
+
+  name = std::get<1>(option_names).empty()
+    ? std::get<0>(option_names)
+    : std::get<1>(option_names);
+
+  return m_options.add_option
+  (
+    m_group,
+    std::get<0>(option_names),
+    std::get<1>(option_names),
+    desc,
+    value,
+    std::move(arg_help)
+  );
+}
+
+inline
+void
+Options::parse_positional(std::string option)
+{
+  parse_positional(std::vector<std::string>{std::move(option)});
+}
+
+inline
+void
+Options::parse_positional(std::vector<std::string> options)
+{
+  m_positional = std::move(options);
+
+  m_positional_set.insert(m_positional.begin(), m_positional.end());
+  m_compiled.reset();
+}
+
+inline
+void
+Options::parse_positional(std::initializer_list<std::string> options)
+{
+  parse_positional(std::vector<std::string>(options));
+}
+
+inline
+CompiledOptions
+Options::compile() const
+{
+  return CompiledOptions(*m_options, m_next_id, m_positional,
+    m_allow_unrecognised, m_sparse_results, m_lazy_conversion);
+}
+
+inline
+std::shared_ptr<const CompiledOptions>
+Options::compiled()
+{
+  if (m_compiled == nullptr)
+  {
+    m_compiled = std::make_shared<CompiledOptions>(compile());
+  }
+
+  return m_compiled;
+}
+
+inline
+ParseResult
+Options::parse(int argc, const char* const* argv)
+{
+  return compiled()->parse(argc, argv);
+}
+
+inline
+ParseResult
+Options::parse(StringView command)
+{
+  return compiled()->parse(command);
+}
+
+template <typename Callback>
+void
+Options::parse(int argc, const char* const* argv, Callback&& callback)
+{
+  compiled()->parse(argc, argv, std::forward<Callback>(callback));
+}
+
+inline
+ParseEvents
+Options::events(int argc, const char* const* argv)
+{
+  const auto schema = compiled();
+  return ParseEvents(*schema, argc, argv, schema);
+}
+
+inline
+IncrementalParser
+Options::incremental()
+{
+  const auto schema = compiled();
+  return IncrementalParser(*schema, schema);
+}
+
+inline
+ParseContext
+Options::context()
+{
+  const auto schema = compiled();
+  return ParseContext(*schema, schema);
+}
+
+inline
+ValidationResult
+Options::validate(int argc, const char* const* argv)
+{
+  return compiled()->validate(argc, argv);
+}
+
+#ifdef CXXOPTS_USE_BULK_PARSING
+inline
+std::vector<BatchResult>
+Options::parse_batch(const std::vector<CommandLine>& lines, unsigned workers)
+{
+  return compiled()->parse_batch(lines, workers);
+}
+
+inline
+CorpusStats
+Options::analyse_corpus
+(
+  StringView corpus,
+  CorpusFormat format,
+  unsigned workers,
+  std::size_t max_values
+)
+{
+  return compiled()->analyse_corpus(corpus, format, workers, max_values);
+}
+#endif
+
+inline
+CompiledOptions::CompiledOptions
+(
+  const OptionMap& options,
+  std::size_t option_count,
+  PositionalList positional,
+  bool allow_unrecognised,
+  bool sparse_results,
+  bool lazy_conversion
+)
+: m_index(std::make_shared<OptionIndex>(options))
+, m_details(option_count)
+, m_allow_unrecognised(allow_unrecognised)
+, m_lazy_conversion(lazy_conversion)
+{
+  m_positional.reserve(positional.size());
+  for (auto& name : positional)
+  {
+    const auto* details = m_index->find(name);
+    m_positional.emplace_back(std::move(name),
+      details == nullptr ? nullptr : *details);
+  }
+
+  m_implicit.resize(option_count);
+  for (const auto& option : options)
+  {
+    const auto& details = option.second;
+    m_details[details->id()] = details;
+    m_implicit[details->id()] = details->value().get_implicit_value();
+
+    const auto& short_name = details->short_name();
+    if (short_name.size() == 1)
+    {
+      m_short_options[static_cast<unsigned char>(short_name[0])] = details;
+    }
+  }
+
+  if (sparse_results)
+  {
+    auto unset = std::make_shared<std::vector<OptionValue>>(option_count);
+
+    for (const auto& details : m_details)
+    {
+      if (details == nullptr)
+      {
+        continue;
+      }
+
+      const auto& value = details->value();
+      auto& result = (*unset)[details->id()];
+
+      if (value.has_default() && !value.is_bound())
+      {
+        result.parse_default(details);
+      }
+      else
+      {
+        result.parse_no_value(details);
+
+        if (value.has_default())
+        {
+          m_bound_defaults.push_back(details);
+        }
+      }
+    }
+
+    m_unset = std::move(unset);
+  }
+}
+
+inline
+ParseResult
+CompiledOptions::parse(int argc, const char* const* argv) const
+{
+  ResultBuilder builder(*this);
+  OptionParser parser(*this);
+
+  for (int i = 1; i < argc; ++i)
+  {
+    parser.feed(argv[i], builder);
+  }
+  parser.finish(builder);
+
+  return builder.result();
+}
+
+template <typename Callback>
+void
+CompiledOptions::parse
+(
+  int argc,
+  const char* const* argv,
+  Callback&& callback
+) const
+{
+  CallbackSink<typename std::remove_reference<Callback>::type>
+    sink(*this, callback);
+  OptionParser parser(*this);
+
+  for (int i = 1; i < argc; ++i)
+  {
+    parser.feed(argv[i], sink);
+  }
+  parser.finish(sink);
+}
+
+inline
+ParseEvents
+CompiledOptions::events(int argc, const char* const* argv) const
+{
+  return ParseEvents(*this, argc, argv);
+}
+
+inline
+IncrementalParser
+CompiledOptions::incremental() const
+{
+  return IncrementalParser(*this);
+}
+
+inline
+ParseResult
+IncrementalParser::finish()
+{
+  m_parser.finish(m_builder);
+  auto result = m_builder.result();
+  reset();
+  return result;
+}
+
+inline
+ParseContext
+CompiledOptions::context() const
+{
+  return ParseContext(*this);
+}
+
+inline
+ValidationResult
+CompiledOptions::validate(int argc, const char* const* argv) const
+{
+  ValidatingSink sink(*this);
+  OptionParser parser(*this);
+
+  for (int i = 1; i < argc; ++i)
+  {
+    parser.feed(argv[i], sink);
+    if (sink.first_error() != ParseError::None)
+    {
+      return ValidationResult(sink.first_error(), i);
+    }
+  }
+
+  parser.finish(sink);
+  if (sink.first_error() != ParseError::None)
+  {
+    return ValidationResult(sink.first_error(), argc - 1);
+  }
+
+  return ValidationResult();
+}
+
+inline
+void
+ValidatingSink::event(const ParseEvent& event)
+{
+  counted(event);
+
+  // implicit values were converted when they were set
+  if (m_error != ParseError::None || event.option() == nullptr ||
+      event.implicit())
+  {
+    return;
+  }
+
+  m_text.assign(event.value().data(), event.value().size());
+#ifndef CXXOPTS_NO_EXCEPTIONS
+  try
+  {
+#endif
+    event.option()->value().slot_ops().check(m_text);
+#ifndef CXXOPTS_NO_EXCEPTIONS
+  }
+  catch (const argument_incorrect_type&)
+  {
+    m_error = ParseError::IncorrectType;
+  }
+#endif
+}
+
+#ifdef CXXOPTS_USE_BULK_PARSING
+inline
+void
+CorpusSink::event(const ParseEvent& event)
+{
+  ValidatingSink::event(event);
+
+  if (first_error() != ParseError::None)
+  {
+    return;
+  }
+
+  if (event.option() != nullptr)
+  {
+    m_events.push_back(Given{event.id(), event.value(), event.implicit()});
+  }
+  else if (event.kind() == ParseEvent::Kind::Unmatched)
+  {
+    ++m_unmatched;
+  }
+}
+
+inline
+void
+CorpusSink::finish_command()
+{
+  ++m_stats.commands;
+
+  if (first_error() != ParseError::None)
+  {
+    ++m_stats.errors[static_cast<std::size_t>(first_error())];
+    return;
+  }
+
+  m_stats.unmatched += m_unmatched;
+  for (const auto& given : m_events)
+  {
+    ++m_stats.uses[given.id];
+    if (!given.implicit)
+    {
+      m_key.assign(given.value.data(), given.value.size());
+      m_stats.count_value(given.id, m_key, 1, m_max_values);
+    }
+  }
+}
+
+inline
+void
+CorpusStats::count_value
+(
+  std::size_t id,
+  const std::string& value,
+  std::size_t times,
+  std::size_t max_values
+)
+{
+  auto& counts = values[id];
+  auto found = counts.find(value);
+
+  if (found != counts.end())
+  {
+    found->second += times;
+  }
+  else if (counts.size() < max_values)
+  {
+    counts.emplace(value, times);
+  }
+  else
+  {
+    other_values[id] += times;
+  }
+}
+
+inline
+void
+CorpusStats::merge(const CorpusStats& other, std::size_t max_values)
+{
+  commands += other.commands;
+  unmatched += other.unmatched;
+
+  for (std::size_t i = 0; i != errors.size(); ++i)
+  {
+    errors[i] += other.errors[i];
+  }
+
+  for (std::size_t id = 0; id != other.uses.size(); ++id)
+  {
+    uses[id] += other.uses[id];
+    other_values[id] += other.other_values[id];
+    for (const auto& value : other.values[id])
+    {
+      count_value(id, value.first, value.second, max_values);
+    }
+  }
+}
+
+inline
+CorpusStats
+CompiledOptions::analyse_corpus
+(
+  StringView corpus,
+  CorpusFormat format,
+  unsigned workers,
+  std::size_t max_values
+) const
+{
+  // Each thread takes the command lines that start in one chunk at a time,
+  // and counts them in its own CorpusStats.
+  const std::size_t chunk_size = std::size_t{1} << 20;
+  const std::size_t chunks = (corpus.size() + chunk_size - 1) / chunk_size;
+
+  if (workers == 0)
+  {
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  workers = static_cast<unsigned>(std::min<std::size_t>(workers,
+    std::max<std::size_t>(chunks, 1)));
+
+  std::vector<CorpusStats> partial(workers, CorpusStats(option_count()));
+  std::atomic<std::size_t> next{0};
+  const char* const data = corpus.data();
+  const std::size_t size = corpus.size();
+
+  auto work = [&](CorpusStats& stats)
+  {
+    CorpusSink sink(*this, stats, max_values);
+    OptionParser parser(*this);
+    std::vector<char> buffer;
+    std::vector<const char*> argv;
+
+    auto analyse = [&](const char* line, const char* line_end)
     {
-      auto desc = o.desc;
+      sink.start_command();
+      parser.reset();
 
-      if (o.has_default && (!o.is_boolean || o.default_value != "false"))
+      if (format == CorpusFormat::Shell)
       {
-        if(!o.default_value.empty())
+        if (line != line_end && line_end[-1] == '\r')
         {
-          desc += toLocalString(" (default: " + o.default_value + ")");
+          --line_end;
+        }
+
+        const bool quoted = values::parser_tool::SplitCommand(
+          StringView(line, static_cast<std::size_t>(line_end - line)),
+          buffer, argv);
+
+        if (!quoted)
+        {
+          sink.error(ParseError::Quoting, std::string());
+        }
+        else if (argv.empty())
+        {
+          return;
         }
         else
         {
-          desc += toLocalString(" (default: \"\")");
+          for (std::size_t i = 1; i < argv.size(); ++i)
+          {
+            parser.feed(argv[i], sink);
+            if (sink.first_error() != ParseError::None)
+            {
+              break;
+            }
+          }
         }
       }
+      else
+      {
+        if (line == line_end)
+        {
+          return;
+        }
 
-      String result;
+        // argv[0] is skipped
+        const char* p = static_cast<const char*>(std::memchr(line, '\0',
+          static_cast<std::size_t>(line_end - line)));
+        p = p == nullptr ? line_end : p + 1;
 
-      if (tab_expansion)
-      {
-        String desc2;
-        auto size = size_t{ 0 };
-        for (auto c = std::begin(desc); c != std::end(desc); ++c)
+        while (p < line_end && sink.first_error() == ParseError::None)
         {
-          if (*c == '\n')
-          {
-            desc2 += *c;
-            size = 0;
-          }
-          else if (*c == '\t')
-          {
-            auto skip = 8 - size % 8;
-            stringAppend(desc2, skip, ' ');
-            size += skip;
-          }
-          else
+          const char* q = static_cast<const char*>(std::memchr(p, '\0',
+            static_cast<std::size_t>(line_end - p)));
+          if (q == nullptr)
           {
-            desc2 += *c;
-            ++size;
+            q = line_end;
           }
+          parser.feed(StringView(p, static_cast<std::size_t>(q - p)), sink);
+          p = q + 1;
         }
-        desc = desc2;
       }
 
-      desc += " ";
-
-      auto current = std::begin(desc);
-      auto previous = current;
-      auto startLine = current;
-      auto lastSpace = current;
+      if (sink.first_error() == ParseError::None)
+      {
+        parser.finish(sink);
+      }
+      sink.finish_command();
+    };
 
-      auto size = size_t{};
+    for (;;)
+    {
+      const auto chunk = next.fetch_add(1, std::memory_order_relaxed);
+      if (chunk >= chunks)
+      {
+        return;
+      }
 
-      bool appendNewLine;
-      bool onlyWhiteSpace = true;
+      std::size_t begin = chunk * chunk_size;
+      const std::size_t end = std::min(begin + chunk_size, size);
 
-      while (current != std::end(desc))
+      // a command line that starts in the previous chunk is read there
+      if (begin != 0)
       {
-        appendNewLine = false;
-
-        if (std::isblank(*previous))
+        const auto* newline = static_cast<const char*>(std::memchr(
+          data + begin - 1, '\n', size - begin + 1));
+        if (newline == nullptr)
         {
-          lastSpace = current;
+          continue;
         }
+        begin = static_cast<std::size_t>(newline - data) + 1;
+      }
 
-        if (!std::isblank(*current))
-        {
-          onlyWhiteSpace = false;
-        }
+      while (begin < end)
+      {
+        const auto* newline = static_cast<const char*>(std::memchr(
+          data + begin, '\n', size - begin));
+        const char* line_end = newline == nullptr ? data + size : newline;
+        analyse(data + begin, line_end);
+        begin = static_cast<std::size_t>(line_end - data) + 1;
+      }
+    }
+  };
 
-        while (*current == '\n')
-        {
-          previous = current;
-          ++current;
-          appendNewLine = true;
-        }
+  std::vector<std::thread> threads;
+  threads.reserve(workers - 1);
+  for (unsigned i = 1; i < workers; ++i)
+  {
+    threads.emplace_back(work, std::ref(partial[i]));
+  }
+  work(partial[0]);
 
-        if (!appendNewLine && size >= allowed)
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  for (unsigned i = 1; i < workers; ++i)
+  {
+    partial[0].merge(partial[i], max_values);
+  }
+
+  return std::move(partial[0]);
+}
+
+inline
+std::vector<BatchResult>
+CompiledOptions::parse_batch
+(
+  const CommandLine* lines,
+  std::size_t count,
+  unsigned workers
+) const
+{
+  std::vector<BatchResult> results(count);
+
+  if (workers == 0)
+  {
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  workers = static_cast<unsigned>(std::min<std::size_t>(workers,
+    std::max<std::size_t>(count, 1)));
+
+  // The command lines are handed out in chunks, small enough that a thread
+  // which finishes early takes work from the others, and large enough that
+  // the shared counter is rarely touched. Each thread writes only to the
+  // results of its own chunks.
+  const std::size_t chunk = count / (std::size_t{workers} * 16) + 1;
+  std::atomic<std::size_t> next{0};
+
+  auto work = [&]
+  {
+    OptionParser parser(*this);
+    ResultBuilder builder(*this);
+
+    for (;;)
+    {
+      const auto begin = next.fetch_add(chunk, std::memory_order_relaxed);
+      if (begin >= count)
+      {
+        return;
+      }
+
+      const auto end = std::min(begin + chunk, count);
+      for (auto i = begin; i != end; ++i)
+      {
+        const auto& line = lines[i];
+#ifndef CXXOPTS_NO_EXCEPTIONS
+        try
         {
-          if (lastSpace != startLine)
+#endif
+          parser.reset();
+          builder.reset();
+          for (int j = 1; j < line.argc; ++j)
           {
-            current = lastSpace;
-            previous = current;
+            parser.feed(line.argv[j], builder);
           }
-          appendNewLine = true;
+          parser.finish(builder);
+          results[i].result = builder.result();
+#ifndef CXXOPTS_NO_EXCEPTIONS
         }
-
-        if (appendNewLine)
+        catch (...)
         {
-          stringAppend(result, startLine, current);
-          startLine = current;
-          lastSpace = current;
+          results[i].error = std::current_exception();
+        }
+#endif
+      }
+    }
+  };
 
-          if (*previous != '\n')
-          {
-            stringAppend(result, "\n");
-          }
+  std::vector<std::thread> threads;
+  threads.reserve(workers - 1);
+  for (unsigned i = 1; i < workers; ++i)
+  {
+    threads.emplace_back(work);
+  }
+  work();
 
-          stringAppend(result, start, ' ');
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
 
-          if (*previous != '\n')
-          {
-            stringAppend(result, lastSpace, current);
-          }
+  return results;
+}
+#endif
 
-          onlyWhiteSpace = true;
-          size = 0;
-        }
+inline
+const ParseResult&
+ParseContext::parse(int argc, const char* const* argv)
+{
+  reset();
 
-        previous = current;
-        ++current;
-        ++size;
-      }
+  for (int i = 1; i < argc; ++i)
+  {
+    m_parser.feed(argv[i], m_builder);
+  }
+  m_parser.finish(m_builder);
 
-      //append whatever is left but ignore whitespace
-      if (!onlyWhiteSpace)
-      {
-        stringAppend(result, startLine, previous);
-      }
+  m_result = m_builder.result();
+  return m_result;
+}
 
-      return result;
+inline
+std::shared_ptr<const ParseResult>
+ParseCache::parse(int argc, const char* const* argv)
+{
+  std::size_t size = 0;
+  const auto hash = hash_arguments(argc, argv, size);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto found = m_index.find(hash);
+    if (found != m_index.end() &&
+        same_arguments(found->second->arguments, argc, argv))
+    {
+      ++m_hits;
+      m_entries.splice(m_entries.begin(), m_entries, found->second);
+      return found->second->result;
     }
-  } // namespace
+
+    ++m_misses;
+  }
+
+  // parsed without the lock, so that other threads can use the cache
+  auto result = std::make_shared<const ParseResult>(
+    m_schema->parse(argc, argv));
+
+  if (m_capacity == 0)
+  {
+    return result;
+  }
+
+  std::string arguments;
+  arguments.reserve(size);
+  for (int i = 1; i < argc; ++i)
+  {
+    arguments.append(argv[i]);
+    arguments.push_back('\0');
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // the same hash for other arguments, or another thread's parse of these
+  auto found = m_index.find(hash);
+  if (found != m_index.end())
+  {
+    auto& entry = *found->second;
+    entry.arguments = std::move(arguments);
+    entry.result = result;
+    m_entries.splice(m_entries.begin(), m_entries, found->second);
+    return result;
+  }
+
+  m_entries.push_front(Entry{hash, std::move(arguments), result});
+  m_index.emplace(hash, m_entries.begin());
+
+  if (m_entries.size() > m_capacity)
+  {
+    m_index.erase(m_entries.back().hash);
+    m_entries.pop_back();
+  }
+
+  return result;
+}
 
 inline
 void
-Options::add_options
+ParseCache::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+  m_index.clear();
+  m_hits = 0;
+  m_misses = 0;
+}
+
+inline
+std::size_t
+ParseCache::size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_entries.size();
+}
+
+inline
+std::size_t
+ParseCache::hits() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_hits;
+}
+
+inline
+std::size_t
+ParseCache::misses() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_misses;
+}
+
+inline
+std::uint64_t
+ParseCache::hash_arguments
 (
-  const std::string &group,
-  std::initializer_list<Option> options
+  int argc,
+  const char* const* argv,
+  std::size_t& size
 )
 {
- OptionAdder option_adder(*this, group);
- for (const auto &option: options)
- {
-   option_adder(option.opts_, option.desc_, option.value_, option.arg_help_);
- }
+  std::uint64_t hash = FNV_OFFSET_BASIS;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const char* p = argv[i];
+    do
+    {
+      hash ^= static_cast<unsigned char>(*p);
+      hash *= FNV_PRIME;
+    } while (*p++ != '\0');
+    size += static_cast<std::size_t>(p - argv[i]);
+  }
+
+  return hash;
+}
+
+inline
+bool
+ParseCache::same_arguments
+(
+  const std::string& arguments,
+  int argc,
+  const char* const* argv
+)
+{
+  std::size_t offset = 0;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const auto size = std::strlen(argv[i]) + 1;
+    if (arguments.size() - offset < size ||
+        std::memcmp(arguments.data() + offset, argv[i], size) != 0)
+    {
+      return false;
+    }
+    offset += size;
+  }
+
+  return offset == arguments.size();
+}
+
+inline
+ParseEvents::ParseEvents
+(
+  const CompiledOptions& schema,
+  int argc,
+  const char* const* argv,
+  std::shared_ptr<const CompiledOptions> owner
+)
+: m_owner(std::move(owner))
+, m_parser(schema)
+, m_buffer(schema)
+, m_argv(argv)
+, m_argc(argc)
+{
+}
+
+inline
+ParseEvents::iterator
+ParseEvents::begin()
+{
+  if (!m_started)
+  {
+    m_started = true;
+    fill();
+  }
+
+  return iterator(this);
+}
+
+inline
+void
+ParseEvents::next()
+{
+  ++m_position;
+  if (at_end())
+  {
+    fill();
+  }
 }
 
 inline
-OptionAdder
-Options::add_options(std::string group)
+void
+ParseEvents::fill()
 {
-  return OptionAdder(*this, std::move(group));
+  m_buffer.m_events.clear();
+  m_position = 0;
+
+  while (m_buffer.m_events.empty())
+  {
+    if (m_next >= m_argc)
+    {
+      if (!m_finished)
+      {
+        m_finished = true;
+        m_parser.finish(m_buffer);
+      }
+      return;
+    }
+
+    m_parser.feed(m_argv[m_next], m_buffer);
+    ++m_next;
+  }
 }
 
 inline
-OptionAdder&
-OptionAdder::operator()
-(
-  const std::string& opts,
-  const std::string& desc,
-  const std::shared_ptr<const Value>& value,
-  std::string arg_help
-)
+void
+OptionParser::feed(StringView argument, ParseSink& sink)
 {
-  std::string short_sw, long_sw;
-  std::tie(short_sw, long_sw) = values::parser_tool::SplitSwitchDef(opts);
+  using values::parser_tool::ArgumentKind;
 
-  if (!short_sw.length() && !long_sw.length())
-  {
-    throw_or_mimic<invalid_option_format_error>(opts);
-  }
-  else if (long_sw.length() == 1 && short_sw.length())
+  if (m_pending != nullptr)
   {
-    throw_or_mimic<invalid_option_format_error>(opts);
+    // the value of the previous option, whatever it looks like
+    const auto& details = *m_pending;
+    m_pending = nullptr;
+    sink.event(ParseEvent(ParseEvent::Kind::Option, &details, m_pending_name,
+      argument));
+    return;
   }
 
-  auto option_names = []
-  (
-    const std::string &short_,
-    const std::string &long_
-  )
+  if (m_end_of_options)
   {
-    if (long_.length() == 1)
+    if (!consume_positional(argument, sink))
     {
-      return std::make_tuple(long_, short_);
+      sink.event(ParseEvent(ParseEvent::Kind::Unmatched, nullptr,
+        StringView(), argument));
     }
-    return std::make_tuple(short_, long_);
-  }(short_sw, long_sw);
+    return;
+  }
 
-  m_options.add_option
-  (
-    m_group,
-    std::get<0>(option_names),
-    std::get<1>(option_names),
-    desc,
-    value,
-    std::move(arg_help)
-  );
+  const auto argu_desc = values::parser_tool::ParseArgument(argument.data(),
+    argument.size());
 
-  return *this;
+  switch (argu_desc.kind)
+  {
+    case ArgumentKind::EndOfOptions:
+      m_end_of_options = true;
+      sink.event(ParseEvent(ParseEvent::Kind::EndOfOptions, nullptr,
+        StringView(), argument));
+      break;
+
+    case ArgumentKind::Long:
+    case ArgumentKind::LongWithValue:
+      parse_option_name(argu_desc, sink);
+      break;
+
+    case ArgumentKind::ShortGroup:
+      parse_short_group(argu_desc, sink);
+      break;
+
+    case ArgumentKind::Malformed:
+    case ArgumentKind::Bare:
+    case ArgumentKind::LoneDash:
+      // starts with a '-' but is not an option
+      if (argu_desc.kind == ArgumentKind::Malformed &&
+          !m_schema->m_allow_unrecognised)
+      {
+        sink.error(ParseError::Syntax, argument.str());
+        return;
+      }
+      // unrecognised arguments are kept like positional ones
+      if (!consume_positional(argument, sink))
+      {
+        sink.event(ParseEvent(ParseEvent::Kind::Unmatched, nullptr,
+          StringView(), argument));
+      }
+      break;
+  }
 }
 
 inline
 void
-OptionParser::parse_default(const std::shared_ptr<OptionDetails>& details)
+OptionParser::finish(ParseSink& sink)
 {
-  // TODO: remove the duplicate code here
-  auto& store = m_parsed[details->hash()];
-  store.parse_default(details);
+  if (m_pending != nullptr)
+  {
+    m_pending = nullptr;
+    sink.error(ParseError::MissingArgument, m_pending_name);
+  }
 }
 
 inline
 void
-OptionParser::parse_no_value(const std::shared_ptr<OptionDetails>& details)
+OptionParser::reset()
 {
-  auto& store = m_parsed[details->hash()];
-  store.parse_no_value(details);
+  m_pending = nullptr;
+  m_pending_name.clear();
+  m_next_positional = 0;
+  m_end_of_options = false;
 }
 
 inline
 void
-OptionParser::parse_option
+OptionParser::parse_option_name
 (
-  const std::shared_ptr<OptionDetails>& value,
-  const std::string& /*name*/,
-  const std::string& arg
+  const values::parser_tool::ArguDesc& argu_desc,
+  ParseSink& sink
 )
 {
-  auto hash = value->hash();
-  auto& result = m_parsed[hash];
-  result.parse(value, arg);
+  const StringView name = argu_desc.arg_name();
+  const auto* details = m_schema->m_index->find(name);
+
+  if (details == nullptr)
+  {
+    if (m_schema->m_allow_unrecognised)
+    {
+      // keep unrecognised options in argument list, skip to next argument
+      sink.event(ParseEvent(ParseEvent::Kind::Unmatched, nullptr,
+        StringView(), argu_desc.token()));
+      return;
+    }
+    //error
+    sink.error(ParseError::UnknownOption, name.str());
+    return;
+  }
 
-  m_sequential.emplace_back(value->long_name(), arg);
+  //equals provided for long option?
+  if (argu_desc.set_value())
+  {
+    sink.event(ParseEvent(ParseEvent::Kind::Option, details, name,
+      argu_desc.value()));
+  }
+  else
+  {
+    checked_parse_arg(*details, name, sink);
+  }
 }
 
 inline
 void
-OptionParser::checked_parse_arg
+OptionParser::parse_short_group
 (
-  int argc,
-  const char* const* argv,
-  int& current,
-  const std::shared_ptr<OptionDetails>& value,
-  const std::string& name
+  const values::parser_tool::ArguDesc& argu_desc,
+  ParseSink& sink
 )
 {
-  if (current + 1 >= argc)
+  const StringView s = argu_desc.arg_name();
+
+  for (std::size_t i = 0; i != s.size(); ++i)
   {
-    if (value->value().has_implicit())
+    const StringView name(s.data() + i, 1);
+    const auto& value =
+      m_schema->m_short_options[static_cast<unsigned char>(s[i])];
+
+    if (value == nullptr)
     {
-      parse_option(value, name, value->value().get_implicit_value());
+      if (m_schema->m_allow_unrecognised)
+      {
+        continue;
+      }
+      //error
+      sink.error(ParseError::UnknownOption, name.str());
+      return;
     }
-    else
+
+    if (i + 1 == s.size())
     {
-      throw_or_mimic<missing_argument_exception>(name);
+      //it must be the last argument
+      checked_parse_arg(value, name, sink);
     }
-  }
-  else
-  {
-    if (value->value().has_implicit())
+    else if (value->value().has_implicit())
     {
-      parse_option(value, name, value->value().get_implicit_value());
+      sink.event(ParseEvent(ParseEvent::Kind::Option, &value, name,
+        m_schema->m_implicit[value->id()], true));
     }
     else
     {
-      parse_option(value, name, argv[current + 1]);
-      ++current;
+      // the rest of the group is the value
+      sink.event(ParseEvent(ParseEvent::Kind::Option, &value, name,
+        s.substr(i + 1)));
+      break;
     }
   }
 }
 
 inline
 void
-OptionParser::add_to_option(OptionMap::const_iterator iter, const std::string& option, const std::string& arg)
+OptionParser::checked_parse_arg
+(
+  const std::shared_ptr<OptionDetails>& details,
+  StringView name,
+  ParseSink& sink
+)
 {
-  parse_option(iter->second, option, arg);
+  if (details->value().has_implicit())
+  {
+    sink.event(ParseEvent(ParseEvent::Kind::Option, &details, name,
+      m_schema->m_implicit[details->id()], true));
+  }
+  else
+  {
+    m_pending = &details;
+    m_pending_name.assign(name.data(), name.size());
+  }
 }
 
 inline
 bool
-OptionParser::consume_positional(const std::string& a, PositionalListIterator& next)
+OptionParser::consume_positional(StringView a, ParseSink& sink)
 {
-  while (next != m_positional.end())
+  const auto& positional = m_schema->m_positional;
+
+  while (m_next_positional != positional.size())
   {
-    auto iter = m_options.find(*next);
-    if (iter != m_options.end())
+    const auto& slot = positional[m_next_positional];
+
+    if (slot.details == nullptr)
     {
-      if (!iter->second->value().is_container())
-      {
-        auto& result = m_parsed[iter->second->hash()];
-        if (result.count() == 0)
-        {
-          add_to_option(iter, *next, a);
-          ++next;
-          return true;
-        }
-        ++next;
-        continue;
-      }
-      add_to_option(iter, *next, a);
+      sink.error(ParseError::UnknownOption, slot.name);
       return true;
     }
-    throw_or_mimic<option_not_exists_exception>(*next);
-  }
 
-  return false;
-}
+    if (slot.is_container)
+    {
+      sink.event(ParseEvent(ParseEvent::Kind::Positional, &slot.details,
+        slot.name, a));
+      return true;
+    }
 
-inline
-void
-Options::parse_positional(std::string option)
-{
-  parse_positional(std::vector<std::string>{std::move(option)});
-}
+    ++m_next_positional;
 
-inline
-void
-Options::parse_positional(std::vector<std::string> options)
-{
-  m_positional = std::move(options);
+    // an option given by name is not filled again from the positionals
+    if (sink.count(slot.details->id()) == 0)
+    {
+      sink.event(ParseEvent(ParseEvent::Kind::Positional, &slot.details,
+        slot.name, a));
+      return true;
+    }
+  }
 
-  m_positional_set.insert(m_positional.begin(), m_positional.end());
+  return false;
 }
 
 inline
 void
-Options::parse_positional(std::initializer_list<std::string> options)
+ResultBuilder::event(const ParseEvent& event)
 {
-  parse_positional(std::vector<std::string>(options));
-}
-
-inline
-ParseResult
-Options::parse(int argc, const char* const* argv)
-{
-  OptionParser parser(*m_options, m_positional, m_allow_unrecognised);
-
-  return parser.parse(argc, argv);
-}
-
-inline ParseResult
-OptionParser::parse(int argc, const char* const* argv)
-{
-  int current = 1;
-  bool consume_remaining = false;
-  auto next_positional = m_positional.begin();
-
-  std::vector<std::string> unmatched;
-
-  while (current != argc)
+  if (event.option() == nullptr)
   {
-    if (strcmp(argv[current], "--") == 0)
-    {
-      consume_remaining = true;
-      ++current;
-      break;
-    }
-    bool matched = false;
-    values::parser_tool::ArguDesc argu_desc =
-        values::parser_tool::ParseArgument(argv[current], matched);
-
-    if (!matched)
+    if (event.kind() == ParseEvent::Kind::Unmatched)
     {
-      //not a flag
-
-      // but if it starts with a `-`, then it's an error
-      if (argv[current][0] == '-' && argv[current][1] != '\0') {
-        if (!m_allow_unrecognised) {
-          throw_or_mimic<option_syntax_exception>(argv[current]);
-        }
-      }
-
-      //if true is returned here then it was consumed, otherwise it is
-      //ignored
-      if (consume_positional(argv[current], next_positional))
+      if (m_spare_unmatched.empty())
       {
+        m_unmatched.emplace_back(event.value().data(), event.value().size());
       }
       else
       {
-        unmatched.emplace_back(argv[current]);
+        m_unmatched.push_back(std::move(m_spare_unmatched.back()));
+        m_spare_unmatched.pop_back();
+        m_unmatched.back().assign(event.value().data(), event.value().size());
       }
-      //if we return from here then it was parsed successfully, so continue
     }
-    else
-    {
-      //short or long option?
-      if (argu_desc.grouping)
-      {
-        const std::string& s = argu_desc.arg_name;
+    return;
+  }
 
-        for (std::size_t i = 0; i != s.size(); ++i)
-        {
-          std::string name(1, s[i]);
-          auto iter = m_options.find(name);
+  const auto& details = event.details();
 
-          if (iter == m_options.end())
-          {
-            if (m_allow_unrecognised)
-            {
-              continue;
-            }
-            //error
-            throw_or_mimic<option_not_exists_exception>(name);
-          }
+  // The argument is copied exactly once, into the result's list of
+  // arguments, and parsed from there.
+  if (m_spare_sequential.empty())
+  {
+    m_sequential.emplace_back(details->long_name(), event.value().str());
+  }
+  else
+  {
+    m_sequential.push_back(std::move(m_spare_sequential.back()));
+    m_spare_sequential.pop_back();
+    auto& argument = m_sequential.back();
+    argument.m_key = details->long_name();
+    argument.m_value.assign(event.value().data(), event.value().size());
+  }
+  const std::string* text = &m_sequential.back().value();
 
-          auto value = iter->second;
+  if (m_schema.m_lazy_conversion && !details->value().is_bound())
+  {
+    store(details->id()).defer(details, event.implicit() ? nullptr : text);
+  }
+  else if (event.implicit())
+  {
+    store(details->id()).parse_implicit(details);
+  }
+  else
+  {
+    store(details->id()).parse(details, *text);
+  }
+}
 
-          if (i + 1 == s.size())
-          {
-            //it must be the last argument
-            checked_parse_arg(argc, argv, current, value, name);
-          }
-          else if (value->value().has_implicit())
-          {
-            parse_option(value, name, value->value().get_implicit_value());
-          }
-          else if (i + 1 < s.size())
-          {
-            std::string arg_value = s.substr(i + 1);
-            parse_option(value, name, arg_value);
-            break;
-          }
-          else
-          {
-            //error
-            throw_or_mimic<option_requires_argument_exception>(name);
-          }
-        }
-      }
-      else if (argu_desc.arg_name.length() != 0)
+inline
+ParseResult
+ResultBuilder::result()
+{
+  if (m_schema.m_unset == nullptr)
+  {
+    for (const auto& detail : m_schema.m_details)
+    {
+      // the id of an option that was added with neither a short nor a long
+      // name, so it can never be given
+      if (detail == nullptr)
       {
-        const std::string& name = argu_desc.arg_name;
-
-        auto iter = m_options.find(name);
-
-        if (iter == m_options.end())
-        {
-          if (m_allow_unrecognised)
-          {
-            // keep unrecognised options in argument list, skip to next argument
-            unmatched.emplace_back(argv[current]);
-            ++current;
-            continue;
-          }
-          //error
-          throw_or_mimic<option_not_exists_exception>(name);
-        }
+        continue;
+      }
 
-        auto opt = iter->second;
+      const auto& value = detail->value();
 
-        //equals provided for long option?
-        if (argu_desc.set_value)
-        {
-          //parse the option given
+      auto& result = m_parsed[detail->id()];
 
-          parse_option(opt, name, argu_desc.value);
-        }
-        else
-        {
-          //parse the next argument
-          checked_parse_arg(argc, argv, current, opt, name);
+      if (value.has_default()) {
+        if (!result.count() && !result.has_default()) {
+          result.parse_default(detail);
         }
       }
-
+      else {
+        result.parse_no_value(detail);
+      }
     }
 
-    ++current;
+    return ParseResult(m_schema.m_index, std::move(m_parsed),
+      std::move(m_sequential), std::move(m_unmatched));
   }
 
-  for (auto& opt : m_options)
+  // every other default is read from the schema when it is accessed
+  for (const auto& detail : m_schema.m_bound_defaults)
   {
-    auto& detail = opt.second;
-    const auto& value = detail->value();
+    if (count(detail->id()) == 0)
+    {
+      store(detail->id()).parse_default(detail);
+    }
+  }
 
-    auto& store = m_parsed[detail->hash()];
+  return ParseResult(m_schema.m_index, std::move(m_ids), std::move(m_parsed),
+    m_schema.m_unset, std::move(m_sequential), std::move(m_unmatched));
+}
 
-    if (value.has_default()) {
-      if (!store.count() && !store.has_default()) {
-        parse_default(detail);
-      }
-    }
-    else {
-      parse_no_value(detail);
-    }
+inline
+void
+ResultBuilder::reset()
+{
+  // the spares are taken from the back, so the strings of the first
+  // arguments are pushed last and reused for the first arguments again
+  while (!m_sequential.empty())
+  {
+    m_spare_sequential.push_back(std::move(m_sequential.back()));
+    m_sequential.pop_back();
+  }
+
+  while (!m_unmatched.empty())
+  {
+    m_spare_unmatched.push_back(std::move(m_unmatched.back()));
+    m_unmatched.pop_back();
   }
 
-  if (consume_remaining)
+  m_ids.clear();
+
+  // a dense result has a value for every option, in the same place on
+  // every parse, so each value can be reused
+  if (m_schema.m_unset == nullptr && m_parsed.size() == m_schema.option_count())
   {
-    while (current < argc)
+    for (auto& value : m_parsed)
     {
-      if (!consume_positional(argv[current], next_positional)) {
-        break;
-      }
-      ++current;
+      value.clear();
     }
+    return;
+  }
 
-    //adjust argv for any that couldn't be swallowed
-    while (current != argc) {
-      unmatched.emplace_back(argv[current]);
-      ++current;
-    }
+  m_parsed.clear();
+  if (m_schema.m_unset == nullptr)
+  {
+    m_parsed.resize(m_schema.option_count());
+  }
+}
+
+inline
+void
+ResultBuilder::recycle(ParseResult& result)
+{
+  if (result.m_index != nullptr)
+  {
+    m_sequential = std::move(result.m_sequential);
+    m_ids = std::move(result.m_ids);
+    m_parsed = std::move(result.m_values);
+    m_unmatched = std::move(result.m_unmatched);
+    result = ParseResult();
+  }
+
+  reset();
+}
+
+inline
+OptionValue&
+ResultBuilder::store(std::size_t id)
+{
+  if (m_schema.m_unset == nullptr)
+  {
+    return m_parsed[id];
   }
 
-  finalise_aliases();
+  auto seen = std::lower_bound(m_ids.begin(), m_ids.end(), id);
+  const auto offset = seen - m_ids.begin();
+
+  if (seen == m_ids.end() || *seen != id)
+  {
+    m_ids.insert(seen, id);
+    m_parsed.insert(m_parsed.begin() + offset, OptionValue());
+  }
 
-  ParseResult parsed(std::move(m_keys), std::move(m_parsed), std::move(m_sequential), std::move(unmatched));
-  return parsed;
+  return m_parsed[static_cast<std::size_t>(offset)];
 }
 
 inline
-void
-OptionParser::finalise_aliases()
+std::size_t
+ResultBuilder::count(std::size_t id) const
 {
-  for (auto& option: m_options)
+  if (m_schema.m_unset == nullptr)
   {
-    auto& detail = *option.second;
-    auto hash = detail.hash();
-    m_keys[detail.short_name()] = hash;
-    m_keys[detail.long_name()] = hash;
+    return m_parsed[id].count();
+  }
 
-    m_parsed.emplace(hash, OptionValue());
+  auto seen = std::lower_bound(m_ids.begin(), m_ids.end(), id);
+  if (seen == m_ids.end() || *seen != id)
+  {
+    return 0;
   }
+
+  return m_parsed[static_cast<std::size_t>(seen - m_ids.begin())].count();
 }
 
 inline
@@ -2369,7 +6086,7 @@ Options::add_option
 }
 
 inline
-void
+std::size_t
 Options::add_option
 (
   const std::string& group,
@@ -2380,8 +6097,24 @@ Options::add_option
   std::string arg_help
 )
 {
+  // check both names first, so that a rejected option neither uses an id
+  // nor leaves one of its names behind
+  for (const auto& name : {s, l})
+  {
+    if (!name.empty() && m_options->count(name) != 0)
+    {
+      throw_or_mimic<option_exists_error>(name);
+    }
+  }
+
+  if (!s.empty() && s == l)
+  {
+    throw_or_mimic<option_exists_error>(s);
+  }
+
   auto stringDesc = toLocalString(std::move(desc));
-  auto option = std::make_shared<OptionDetails>(s, l, stringDesc, value);
+  auto option = std::make_shared<OptionDetails>(s, l, stringDesc, value,
+    m_next_id);
 
   if (!s.empty())
   {
@@ -2392,11 +6125,7 @@ Options::add_option
   {
     add_one_option(l, option);
   }
-
-  m_option_list.push_front(*option.get());
-  auto iter = m_option_list.begin();
-  m_option_map[s] = iter;
-  m_option_map[l] = iter;
+  ++m_next_id;
 
   //add the help details
   auto& options = m_help[group];
@@ -2407,6 +6136,8 @@ Options::add_option
       std::move(arg_help),
       value->is_container(),
       value->is_boolean()});
+
+  return option->id();
 }
 
 inline
@@ -2423,6 +6154,8 @@ Options::add_one_option
   {
     throw_or_mimic<option_exists_error>(option);
   }
+
+  m_compiled.reset();
 }
 
 inline
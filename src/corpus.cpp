@@ -0,0 +1,239 @@
+/*
+
+Copyright (c) 2014 Jarryd Beck
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+// Reads a corpus of recorded command lines, one per line, and reports how the
+// options of a sample compiler driver are used in them.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#define CXXOPTS_USE_BULK_PARSING
+#include "cxxopts.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CXXOPTS_CORPUS_MMAP
+#endif
+
+namespace
+{
+  // The contents of a file, mapped into memory where that is possible.
+  class Corpus
+  {
+    public:
+    explicit Corpus(const std::string& path)
+    {
+#ifdef CXXOPTS_CORPUS_MMAP
+      const int fd = ::open(path.c_str(), O_RDONLY);
+      struct stat status{};
+      if (fd >= 0 && ::fstat(fd, &status) == 0)
+      {
+        m_size = static_cast<std::size_t>(status.st_size);
+        if (m_size == 0)
+        {
+          ::close(fd);
+          return;
+        }
+
+        void* mapped = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped != MAP_FAILED)
+        {
+          ::madvise(mapped, m_size, MADV_SEQUENTIAL);
+          m_mapped = mapped;
+          return;
+        }
+        m_size = 0;
+      }
+      else if (fd >= 0)
+      {
+        ::close(fd);
+      }
+#endif
+
+      std::ifstream in(path, std::ios::binary);
+      if (!in)
+      {
+        throw std::runtime_error("cannot read " + path);
+      }
+      std::ostringstream contents;
+      contents << in.rdbuf();
+      m_contents = contents.str();
+    }
+
+    Corpus(const Corpus&) = delete;
+    Corpus& operator=(const Corpus&) = delete;
+
+    ~Corpus()
+    {
+#ifdef CXXOPTS_CORPUS_MMAP
+      if (m_mapped != nullptr)
+      {
+        ::munmap(m_mapped, m_size);
+      }
+#endif
+    }
+
+    cxxopts::StringView
+    text() const
+    {
+      if (m_mapped != nullptr)
+      {
+        return cxxopts::StringView(static_cast<const char*>(m_mapped), m_size);
+      }
+      return cxxopts::StringView(m_contents.data(), m_contents.size());
+    }
+
+    private:
+    void* m_mapped = nullptr;
+    std::size_t m_size = 0;
+    std::string m_contents{};
+  };
+
+  void
+  report(const cxxopts::CompiledOptions& schema,
+    const cxxopts::CorpusStats& stats, std::size_t top)
+  {
+    std::cout << "errors: " << stats.error_count() << '\n';
+    for (std::size_t i = 1; i != stats.errors.size(); ++i)
+    {
+      if (stats.errors[i] != 0)
+      {
+        std::cout << "  "
+          << cxxopts::parse_error_name(static_cast<cxxopts::ParseError>(i))
+          << ": " << stats.errors[i] << '\n';
+      }
+    }
+    std::cout << "unmatched arguments: " << stats.unmatched << '\n';
+
+    for (std::size_t id = 0; id != stats.uses.size(); ++id)
+    {
+      const auto* option = schema.option(id);
+      if (option == nullptr || stats.uses[id] == 0)
+      {
+        continue;
+      }
+
+      const auto& name = option->long_name().empty()
+        ? option->short_name() : option->long_name();
+      std::cout << name << ": " << stats.uses[id] << '\n';
+
+      std::vector<std::pair<std::string, std::size_t>> values(
+        stats.values[id].begin(), stats.values[id].end());
+      const auto shown = std::min(top, values.size());
+      std::partial_sort(values.begin(), values.begin() + static_cast<long>(shown),
+        values.end(), [](const std::pair<std::string, std::size_t>& a,
+          const std::pair<std::string, std::size_t>& b)
+      {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+      });
+
+      for (std::size_t i = 0; i != shown; ++i)
+      {
+        if (!values[i].first.empty())
+        {
+          std::cout << "  " << values[i].first << ": " << values[i].second << '\n';
+        }
+      }
+      if (stats.other_values[id] != 0)
+      {
+        std::cout << "  (others): " << stats.other_values[id] << '\n';
+      }
+    }
+  }
+}
+
+int main(int argc, const char* argv[])
+{
+  cxxopts::Options options(argv[0], " - option usage across a corpus of "
+    "command lines");
+  options
+    .positional_help("FILE")
+    .add_options()
+    ("cmdline", "Lines are '\\0' separated arguments, as in /proc/<pid>/cmdline")
+    ("t,threads", "Number of threads, 0 for one per hardware thread",
+      cxxopts::value<unsigned>()->default_value("0"), "N")
+    ("top", "Number of values to show for each option",
+      cxxopts::value<std::size_t>()->default_value("5"), "N")
+    ("file", "The corpus", cxxopts::value<std::string>())
+    ("h,help", "Print help");
+  options.parse_positional({"file"});
+
+  // the command lines in the corpus are read with this schema
+  cxxopts::Options driver("cc", "sample compiler driver");
+  driver
+    .allow_unrecognised_options()
+    .add_options()
+    ("c", "Compile only")
+    ("v,verbose", "Verbose")
+    ("g", "Debug information")
+    ("o,output", "Output file", cxxopts::value<std::string>())
+    ("O,optimize", "Optimisation level", cxxopts::value<std::string>())
+    ("j,jobs", "Jobs", cxxopts::value<int>())
+    ("I,include", "Include path", cxxopts::value<std::vector<std::string>>())
+    ("D,define", "Define", cxxopts::value<std::vector<std::string>>())
+    ("std", "Language standard", cxxopts::value<std::string>())
+    ("inputs", "Inputs", cxxopts::value<std::vector<std::string>>());
+  driver.parse_positional({"inputs"});
+
+  try
+  {
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") || !result.count("file"))
+    {
+      std::cout << options.help() << std::endl;
+      return result.count("help") ? 0 : 1;
+    }
+
+    const Corpus corpus(result["file"].as<std::string>());
+    const auto format = result.count("cmdline")
+      ? cxxopts::CorpusFormat::Cmdline : cxxopts::CorpusFormat::Shell;
+    const auto schema = driver.compiled();
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto stats = schema->analyse_corpus(corpus.text(), format,
+      result["threads"].as<unsigned>());
+    const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+    std::cout << "lines: " << stats.commands << " in " << elapsed.count()
+      << " s (" << static_cast<double>(stats.commands) / elapsed.count()
+      << " lines/s)\n";
+    report(*schema, stats, result["top"].as<std::size_t>());
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -1,7 +1,11 @@
 #include "catch.hpp"
 
 #include <initializer_list>
+#include <random>
+#include <regex>
+#include <thread>
 
+#define CXXOPTS_USE_BULK_PARSING
 #include "cxxopts.hpp"
 
 class Argv {
@@ -231,6 +235,32 @@ TEST_CASE("Positional not valid", "[positional]") {
   CHECK_THROWS_AS(options.parse(argc, argv), cxxopts::option_not_exists_exception&);
 }
 
+TEST_CASE("Positional plan", "[positional]") {
+  cxxopts::Options options("positional_plan", "positionals resolved once");
+  options.add_options()
+      ("c,count", "a count", cxxopts::value<int>())
+      ("rest", "everything else", cxxopts::value<std::vector<std::string>>())
+      ;
+
+  options.parse_positional({"c", "rest", "missing"});
+  const auto compiled = options.compile();
+  options.parse_positional("missing");
+
+  Argv none({"plan", "--count", "4"});
+  auto result = compiled.parse(none.argc(), none.argv());
+  CHECK(result["count"].as<int>() == 4);
+  CHECK(result.count("rest") == 0);
+
+  Argv av({"plan", "5", "x", "y"});
+  result = compiled.parse(av.argc(), av.argv());
+  CHECK(result["count"].as<int>() == 5);
+  CHECK((result["rest"].as<std::vector<std::string>>() ==
+    std::vector<std::string>{"x", "y"}));
+
+  CHECK_THROWS_AS(options.parse(av.argc(), av.argv()),
+    cxxopts::option_not_exists_exception&);
+}
+
 TEST_CASE("Empty with implicit value", "[implicit]")
 {
   cxxopts::Options options("empty_implicit", "doesn't handle empty");
@@ -804,3 +834,1483 @@ TEST_CASE("Parameter follow option", "[parameter]") {
   CHECK(job_values[2] == 10);
   CHECK(job_values[3] == 5);
 }
+
+namespace {
+
+// The grammar that the option scanners implement, as it was originally
+// written with std::regex. The scanners must agree with these exactly.
+const std::regex integer_pattern("(-)?(0x)?([0-9a-zA-Z]+)|((0x)?0)");
+const std::regex truthy_pattern("(t|T)(rue)?|1");
+const std::regex falsy_pattern("(f|F)(alse)?|0");
+const std::regex option_matcher
+  ("--([[:alnum:]][-_[:alnum:]]+)(=(.*))?|-([[:alnum:]]+)");
+const std::regex option_specifier
+  ("(([[:alnum:]]),)?[ ]*([[:alnum:]][-_[:alnum:]]*)?");
+
+std::string
+regex_argument(const std::string& text)
+{
+  std::smatch m;
+  if (!std::regex_match(text, m, option_matcher))
+  {
+    return "no match";
+  }
+  if (m.length(4) > 0)
+  {
+    return "group:" + m.str(4);
+  }
+  return "long:" + m.str(1) + (m.length(2) > 0 ? "=" + m.str(3) : "");
+}
+
+std::string
+scanned_argument(const std::string& text)
+{
+  auto desc = cxxopts::values::parser_tool::ParseArgument(text.c_str());
+  if (!desc.is_option())
+  {
+    return "no match";
+  }
+  if (desc.grouping())
+  {
+    return "group:" + desc.arg_name().str();
+  }
+  return "long:" + desc.arg_name().str() +
+    (desc.set_value() ? "=" + desc.value().str() : "");
+}
+
+std::string
+regex_integer(const std::string& text)
+{
+  std::smatch m;
+  if (!std::regex_match(text, m, integer_pattern) || m.length() == 0)
+  {
+    return "no match";
+  }
+  if (m.length(4) > 0)
+  {
+    return m.str(1) + "|" + m.str(5) + "|0";
+  }
+  return m.str(1) + "|" + m.str(2) + "|" + m.str(3);
+}
+
+std::string
+scanned_integer(const std::string& text)
+{
+  try
+  {
+    auto desc = cxxopts::values::parser_tool::SplitInteger(text);
+    return desc.negative + "|" + desc.base + "|" + desc.value;
+  }
+  catch (const cxxopts::argument_incorrect_type&)
+  {
+    return "no match";
+  }
+}
+
+std::string
+regex_specifier(const std::string& text)
+{
+  std::smatch m;
+  if (!std::regex_match(text, m, option_specifier))
+  {
+    return "no match";
+  }
+  return m.str(2) + "|" + m.str(3);
+}
+
+std::string
+scanned_specifier(const std::string& text)
+{
+  try
+  {
+    auto names = cxxopts::values::parser_tool::SplitSwitchDef(text);
+    return names.first + "|" + names.second;
+  }
+  catch (const cxxopts::invalid_option_format_error&)
+  {
+    return "no match";
+  }
+}
+
+void
+check_scanners_agree(const std::string& text)
+{
+  using namespace cxxopts::values::parser_tool;
+
+  INFO("input: \"" << text << "\"");
+  CHECK(scanned_argument(text) == regex_argument(text));
+  CHECK(scanned_integer(text) == regex_integer(text));
+  CHECK(scanned_specifier(text) == regex_specifier(text));
+  CHECK(IsTrueText(text) == std::regex_match(text, truthy_pattern));
+  CHECK(IsFalseText(text) == std::regex_match(text, falsy_pattern));
+}
+
+// Calls `f` with every string over `alphabet` of length up to `length`.
+template <typename F>
+void
+for_each_string(const std::string& alphabet, size_t length, F f)
+{
+  std::string text;
+  f(text);
+  std::vector<size_t> digits;
+  while (digits.size() <= length)
+  {
+    size_t i = 0;
+    while (i != digits.size() && ++digits[i] == alphabet.size())
+    {
+      digits[i] = 0;
+      ++i;
+    }
+    if (i == digits.size())
+    {
+      digits.push_back(0);
+      if (digits.size() > length)
+      {
+        break;
+      }
+    }
+    text.resize(digits.size());
+    for (size_t j = 0; j != digits.size(); ++j)
+    {
+      text[j] = alphabet[digits[j]];
+    }
+    f(text);
+  }
+}
+
+} // namespace
+
+TEST_CASE("Scanners agree with the regex grammar", "[scanner]") {
+  size_t failures = 0;
+  auto check = [&failures](const std::string& text) {
+    if (scanned_argument(text) != regex_argument(text) ||
+        scanned_integer(text) != regex_integer(text) ||
+        scanned_specifier(text) != regex_specifier(text) ||
+        cxxopts::values::parser_tool::IsTrueText(text) !=
+          std::regex_match(text, truthy_pattern) ||
+        cxxopts::values::parser_tool::IsFalseText(text) !=
+          std::regex_match(text, falsy_pattern))
+    {
+      // Only report the details of a handful of failures.
+      if (++failures <= 10)
+      {
+        check_scanners_agree(text);
+      }
+    }
+  };
+
+  SECTION("Exhaustive short strings") {
+    for_each_string("-=a0x_ ,\n", 5, check);
+  }
+
+  SECTION("Boolean and integer words") {
+    for_each_string("tTrueFals01x-", 4, check);
+  }
+
+  SECTION("Random long strings") {
+    const std::string alphabet = "--==aZ09x_ ,.\n\r\t\xc3tTruefF";
+    std::mt19937 generator(2014);
+    std::uniform_int_distribution<size_t> length(0, 40);
+    std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+
+    for (int i = 0; i != 20000; ++i)
+    {
+      std::string text(length(generator), ' ');
+      for (auto& c : text)
+      {
+        c = alphabet[pick(generator)];
+      }
+      // Bias towards strings that look like options.
+      if (i % 3 == 0)
+      {
+        text.insert(0, i % 2 == 0 ? "--" : "-");
+      }
+      check(text);
+    }
+  }
+
+  CHECK(failures == 0);
+}
+
+TEST_CASE("Argument descriptions refer to argv", "[scanner]") {
+  using cxxopts::values::parser_tool::ArgumentKind;
+  using cxxopts::values::parser_tool::ParseArgument;
+
+  const char* const argv[] = {
+    "tester",
+    "--file=data.txt",
+    "-xvf",
+    "input-file",
+    "--verbose",
+    "-",
+    "--",
+    "-x=1",
+  };
+
+  std::vector<cxxopts::values::parser_tool::ArguDesc> arguments;
+  for (const auto* arg : argv)
+  {
+    arguments.push_back(ParseArgument(arg));
+  }
+
+  for (size_t i = 0; i != arguments.size(); ++i)
+  {
+    CHECK(arguments[i].token().data() == argv[i]);
+    CHECK(arguments[i].length == strlen(argv[i]));
+  }
+
+  const auto& long_value = arguments[1];
+  CHECK(long_value.kind == ArgumentKind::LongWithValue);
+  CHECK(long_value.equals == 6);
+  CHECK(long_value.arg_name().data() == argv[1] + 2);
+  CHECK(long_value.arg_name() == "file");
+  CHECK(long_value.value().data() == argv[1] + 7);
+  CHECK(long_value.value() == "data.txt");
+
+  CHECK(arguments[2].kind == ArgumentKind::ShortGroup);
+  CHECK(arguments[2].arg_name().data() == argv[2] + 1);
+  CHECK(arguments[2].arg_name() == "xvf");
+
+  CHECK(arguments[0].kind == ArgumentKind::Bare);
+  CHECK(arguments[3].kind == ArgumentKind::Bare);
+  CHECK(arguments[4].kind == ArgumentKind::Long);
+  CHECK(arguments[4].arg_name() == "verbose");
+  CHECK(arguments[5].kind == ArgumentKind::LoneDash);
+  CHECK(arguments[6].kind == ArgumentKind::EndOfOptions);
+  CHECK(arguments[7].kind == ArgumentKind::Malformed);
+}
+
+TEST_CASE("Option index", "[index]") {
+  cxxopts::OptionMap map;
+  for (int i = 0; i != 3000; ++i)
+  {
+    auto name = "option-" + std::to_string(i);
+    map.emplace(name, std::make_shared<cxxopts::OptionDetails>("", name, "",
+      cxxopts::value<int>(), map.size()));
+  }
+  auto short_details = std::make_shared<cxxopts::OptionDetails>("x", "extra",
+    "", cxxopts::value<bool>(), map.size());
+  map.emplace("x", short_details);
+  map.emplace("extra", short_details);
+
+  cxxopts::OptionIndex index(map);
+
+  size_t found = 0;
+  for (const auto& entry : map)
+  {
+    auto details = index.find(entry.first);
+    if (details != nullptr && details->get() == entry.second.get())
+    {
+      ++found;
+    }
+  }
+  CHECK(found == map.size());
+
+  CHECK(index.find("option-3000") == nullptr);
+  CHECK(index.find("option") == nullptr);
+  CHECK(index.find("y") == nullptr);
+  CHECK(index.find("") == nullptr);
+
+  cxxopts::OptionIndex empty;
+  CHECK(empty.find("x") == nullptr);
+}
+
+TEST_CASE("Option names with the same hash", "[index]") {
+  // two names with the same 64-bit FNV-1a hash, which no perfect hash
+  // table can separate
+  const std::string first = "c5c8112fd1718e8c";
+  const std::string second = "26de1852256a7349";
+  REQUIRE(cxxopts::hash_name(first) == cxxopts::hash_name(second));
+
+  cxxopts::Options options("colliding", " - names with the same hash");
+  options.add_options()
+    ("a," + first, "first", cxxopts::value<int>())
+    (second, "second", cxxopts::value<int>())
+    ("other", "other", cxxopts::value<int>())
+    ;
+
+  Argv av({"colliding", "--c5c8112fd1718e8c", "1", "--26de1852256a7349", "2",
+    "-a", "3", "--other", "4"});
+  auto result = options.parse(av.argc(), av.argv());
+
+  CHECK(result[first].as<int>() == 3);
+  CHECK(result.count(first) == 2);
+  CHECK(result[second].as<int>() == 2);
+  CHECK(result["other"].as<int>() == 4);
+  CHECK(result.count("c5c8112fd1718e8d") == 0);
+}
+
+TEST_CASE("Long groups of short options", "[options]") {
+  cxxopts::Options options("short_groups", " - test grouped short options");
+  options.add_options()
+    ("a", "a flag")
+    ("b,bee", "another flag")
+    ("Z", "an uppercase flag")
+    ("9", "a numeric flag")
+    ("n,number", "a value", cxxopts::value<int>())
+    ;
+
+  Argv av({"short_groups", "-abZ9abZ9n42", "-aaan", "7"});
+
+  auto** argv = av.argv();
+  auto argc = av.argc();
+
+  auto result = options.parse(argc, argv);
+
+  CHECK(result.count("a") == 5);
+  CHECK(result.count("bee") == 2);
+  CHECK(result.count("Z") == 2);
+  CHECK(result.count("9") == 2);
+  REQUIRE(result.count("number") == 2);
+  CHECK(result["n"].as<int>() == 7);
+
+  Argv unknown({"short_groups", "-abq"});
+  CHECK_THROWS_AS(options.parse(unknown.argc(), unknown.argv()),
+    cxxopts::option_not_exists_exception&);
+}
+
+TEST_CASE("Options with concatenated names are distinct", "[options]") {
+  cxxopts::Options options("distinct", " - names that concatenate the same");
+  options.add_options()
+    ("a,bc", "short and long", cxxopts::value<std::string>())
+    ("bca", "long only", cxxopts::value<std::string>())
+    ;
+
+  Argv av({"distinct", "-a", "first", "--bca", "second"});
+
+  auto** argv = av.argv();
+  auto argc = av.argc();
+
+  auto result = options.parse(argc, argv);
+
+  CHECK(result.count("a") == 1);
+  CHECK(result.count("bc") == 1);
+  CHECK(result.count("bca") == 1);
+  CHECK(result["bc"].as<std::string>() == "first");
+  CHECK(result["bca"].as<std::string>() == "second");
+  CHECK(result.count("") == 0);
+}
+
+TEST_CASE("Rejected options do not use an id", "[options]") {
+  cxxopts::Options options("dense", " - ids stay dense");
+  auto adder = options.add_options();
+  CHECK(adder.add<int>("a,apple", "first").id() == 0);
+
+  CHECK_THROWS_AS(adder("a,avocado", "short name taken"),
+    cxxopts::option_exists_error&);
+  CHECK_THROWS_AS(adder("b,apple", "long name taken"),
+    cxxopts::option_exists_error&);
+
+  CHECK(adder.add<int>("b,banana", "second").id() == 1);
+
+  // the names of a rejected option were not registered
+  CHECK(adder.add<int>("avocado", "third").id() == 2);
+
+  const auto compiled = options.compiled();
+  REQUIRE(compiled->option_count() == 3);
+  for (std::size_t id = 0; id != compiled->option_count(); ++id)
+  {
+    REQUIRE(compiled->option(id) != nullptr);
+    CHECK(compiled->option(id)->id() == id);
+  }
+
+  Argv av({"dense", "-b", "2"});
+  auto result = options.parse(av.argc(), av.argv());
+  CHECK(result["banana"].as<int>() == 2);
+  CHECK(result.count("apple") == 0);
+}
+
+TEST_CASE("Result outlives its options", "[result]") {
+  cxxopts::ParseResult result;
+  CHECK(result.count("value") == 0);
+  CHECK_THROWS_AS(result["value"], cxxopts::option_not_present_exception&);
+
+  {
+    cxxopts::Options options("outlives", " - result outlives options");
+    options.add_options()
+      ("v,value", "a value", cxxopts::value<int>())
+      ("other", "an unused value", cxxopts::value<int>())
+      ;
+
+    Argv av({"outlives", "-v", "3"});
+    result = options.parse(av.argc(), av.argv());
+  }
+
+  CHECK(result.count("value") == 1);
+  CHECK(result["v"].as<int>() == 3);
+  CHECK(result.count("other") == 0);
+  CHECK(result.count("missing") == 0);
+  CHECK_THROWS_AS(result["missing"], cxxopts::option_not_present_exception&);
+}
+
+TEST_CASE("Option handles", "[handle]") {
+  cxxopts::Options options("handles", " - read values through handles");
+
+  auto adder = options.add_options();
+  auto port = adder.add<int>("p,port", "a port");
+  auto host = adder.add<std::string>("host", "a host name",
+    cxxopts::value<std::string>()->default_value("localhost"));
+  auto verbose = adder.add<bool>("v,verbose", "verbose output");
+  auto files = adder.add<std::vector<std::string>>("files", "input files");
+  adder("other", "an option without a handle", cxxopts::value<int>());
+
+  CHECK_THROWS_AS(adder.add<int>("name", "mismatched type",
+    cxxopts::value<std::string>()), cxxopts::invalid_option_type_error&);
+
+  options.parse_positional("files");
+
+  Argv av({"handles", "-p", "8080", "--other", "1", "a", "b"});
+
+  auto result = options.parse(av.argc(), av.argv());
+
+  CHECK(result.count(port) == 1);
+  CHECK(result.get(port) == 8080);
+  CHECK(result.count(host) == 0);
+  CHECK(result.get(host) == "localhost");
+  CHECK(result.get(verbose) == false);
+  CHECK((result.get(files) == std::vector<std::string>{"a", "b"}));
+
+  // A handle of the wrong type for an option is caught on access.
+  cxxopts::OptionHandle<std::string> wrong(port.id());
+  CHECK_THROWS_AS(result.get(wrong), cxxopts::invalid_option_type_error&);
+
+  cxxopts::OptionHandle<int> invalid;
+  CHECK(result.count(invalid) == 0);
+  CHECK_THROWS_AS(result.get(invalid), cxxopts::option_not_present_exception&);
+
+  // A handle from other options is not present, even with a matching id.
+  cxxopts::Options others("others", " - other options");
+  auto other_port = others.add_options().add<int>("p,port", "a port");
+  REQUIRE(other_port.id() == port.id());
+  CHECK(result.count(other_port) == 0);
+  CHECK_THROWS_AS(result.get(other_port), cxxopts::option_not_present_exception&);
+
+  try
+  {
+    result.get(other_port);
+  }
+  catch (const cxxopts::option_not_present_exception& e)
+  {
+    CHECK(std::string(e.what()).find("port") != std::string::npos);
+  }
+}
+
+TEST_CASE("Compile time keys", "[key]") {
+  using namespace cxxopts::literals;
+
+  constexpr auto verbose = cxxopts::key("verbose");
+  static_assert(verbose.hash() == "verbose"_opt.hash(), "same hash");
+  static_assert(verbose.name().size() == 7, "literal without terminator");
+  CHECK(verbose.hash() == cxxopts::hash_name("verbose"));
+
+  cxxopts::Options options("keys", " - look up options with keys");
+  options.add_options()
+    ("v,verbose", "verbose output")
+    ("l,level", "a level", cxxopts::value<int>())
+    ;
+
+  Argv av({"keys", "-v", "--level", "3"});
+  auto result = options.parse(av.argc(), av.argv());
+
+  CHECK(result.count(verbose) == 1);
+  CHECK(result.count("v"_opt) == 1);
+  CHECK(result["level"_opt].as<int>() == 3);
+  CHECK(result[cxxopts::key("l")].as<int>() == 3);
+  CHECK(result.count("missing"_opt) == 0);
+  CHECK_THROWS_AS(result["missing"_opt], cxxopts::option_not_present_exception&);
+}
+
+TEST_CASE("Look up results by string views", "[result]") {
+  cxxopts::Options options("views", " - look up options without allocating");
+  options.add_options()
+    ("f,file", "a file", cxxopts::value<std::string>())
+    ("q,quiet", "no output")
+    ;
+
+  Argv av({"views", "-f", "name", "--quiet"});
+  auto result = options.parse(av.argc(), av.argv());
+
+  const char* file = "file-and-more";
+  const std::string quiet = "quiet";
+
+  CHECK(result.count(cxxopts::StringView(file, 4)) == 1);
+  CHECK(result[cxxopts::StringView(file, 4)].as<std::string>() == "name");
+  CHECK(result.count(cxxopts::StringView(file, 1)) == 1);
+  CHECK(result.count(cxxopts::StringView(file)) == 0);
+  CHECK(result.count(quiet) == 1);
+  CHECK(result.count("q") == 1);
+  CHECK_THROWS_AS(result[cxxopts::StringView(file, 6)],
+    cxxopts::option_not_present_exception&);
+
+#ifdef CXXOPTS_HAS_STRING_VIEW
+  CHECK(result.count(std::string_view("file")) == 1);
+#endif
+}
+
+TEST_CASE("Compiled options", "[compile]") {
+  cxxopts::Options options("compiled", " - parse with a compiled schema");
+  options.add_options()
+    ("n,number", "a number", cxxopts::value<int>())
+    ("v,verbose", "verbose output")
+    ("d,depth", "a depth", cxxopts::value<int>()->default_value("2"))
+    ("files", "input files", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional("files");
+
+  const auto compiled = options.compile();
+  CHECK(compiled.option_count() == 4);
+
+  SECTION("Later changes do not affect it") {
+    options.add_options()("extra", "added after compiling");
+
+    Argv av({"compiled", "--extra"});
+    CHECK_THROWS_AS(compiled.parse(av.argc(), av.argv()),
+      cxxopts::option_not_exists_exception&);
+    CHECK(options.parse(av.argc(), av.argv()).count("extra") == 1);
+  }
+
+  SECTION("Parse from several threads") {
+    const int threads = 8;
+    const int iterations = 200;
+    std::vector<int> failures(threads);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t != threads; ++t)
+    {
+      workers.emplace_back([&compiled, &failures, t] {
+        for (int i = 0; i != iterations; ++i)
+        {
+          const auto number = std::to_string(t * iterations + i);
+          Argv av({"compiled", "-vn", number.c_str(), "a", "b"});
+          auto result = compiled.parse(av.argc(), av.argv());
+
+          if (result["number"].as<int>() != t * iterations + i ||
+              result.count("verbose") != 1 ||
+              result["depth"].as<int>() != 2 ||
+              result["files"].as<std::vector<std::string>>().size() != 2)
+          {
+            ++failures[static_cast<size_t>(t)];
+          }
+        }
+      });
+    }
+
+    for (auto& worker : workers)
+    {
+      worker.join();
+    }
+
+    CHECK(std::count(failures.begin(), failures.end(), 0) == threads);
+  }
+}
+
+TEST_CASE("Converted default and implicit values", "[default]") {
+  cxxopts::Options options("converted", " - defaults converted once");
+  options.add_options()
+    ("n,number", "a number", cxxopts::value<int>()->default_value(7))
+    ("r,ratio", "a ratio", cxxopts::value<double>()->default_value(0.5)
+      ->implicit_value(1.5))
+    ("b,bit", "a bit", cxxopts::value<bool>()->default_value(true))
+    ("l,list", "a list", cxxopts::value<std::vector<int>>()
+      ->implicit_value("1,2"))
+    ("s,name", "a name", cxxopts::value<std::string>()->default_value("anon"))
+    ;
+
+  SECTION("Defaults") {
+    Argv av({"converted"});
+    auto result = options.parse(av.argc(), av.argv());
+
+    CHECK(result["number"].as<int>() == 7);
+    CHECK(result["ratio"].as<double>() == 0.5);
+    CHECK(result["bit"].as<bool>());
+    CHECK(result["name"].as<std::string>() == "anon");
+    CHECK(result["number"].has_default());
+  }
+
+  SECTION("Implicit values are added like parsed ones") {
+    Argv av({"converted", "-l", "--list", "-r"});
+    auto result = options.parse(av.argc(), av.argv());
+
+    CHECK((result["list"].as<std::vector<int>>() ==
+      std::vector<int>{1, 2, 1, 2}));
+    CHECK(result["ratio"].as<double>() == 1.5);
+
+    const auto& arguments = result.arguments();
+    REQUIRE(arguments.size() == 3);
+    CHECK(arguments[0].value() == "1,2");
+    CHECK(arguments[2].value() == "1.5");
+  }
+
+  SECTION("Help shows typed values") {
+    const auto help = options.help();
+    CHECK(help.find("(default: 7)") != std::string::npos);
+    CHECK(help.find("(default: 0.5)") != std::string::npos);
+  }
+
+  SECTION("Invalid defaults are reported when set") {
+    CHECK_THROWS_AS(cxxopts::value<int>()->default_value("seven"),
+      cxxopts::argument_incorrect_type&);
+    CHECK_THROWS_AS(cxxopts::value<bool>()->implicit_value("maybe"),
+      cxxopts::argument_incorrect_type&);
+  }
+}
+
+TEST_CASE("Sparse results", "[sparse]") {
+  int bound = 0;
+
+  cxxopts::Options options("sparse", " - only store given options");
+  options.set_sparse_results();
+  auto adder = options.add_options();
+  adder
+    ("v,verbose", "verbose output")
+    ("d,depth", "a depth", cxxopts::value<int>()->default_value("3"))
+    ("b,bound", "a bound value", cxxopts::value<int>(bound)->default_value("9"))
+    ("n,name", "a name", cxxopts::value<std::string>())
+    ("files", "input files", cxxopts::value<std::vector<std::string>>())
+    ;
+  auto depth = adder.add<int>("level", "a level",
+    cxxopts::value<int>()->default_value("1"));
+
+  for (int i = 0; i != 100; ++i)
+  {
+    adder(("option" + std::to_string(i)).c_str(), "unused",
+      cxxopts::value<int>()->default_value(std::to_string(i)));
+  }
+
+  options.parse_positional("files");
+
+  Argv av({"sparse", "-v", "-d", "5", "x", "y"});
+  auto result = options.parse(av.argc(), av.argv());
+
+  CHECK(result.count("verbose") == 1);
+  CHECK(result["verbose"].as<bool>());
+  CHECK(result["depth"].as<int>() == 5);
+  CHECK(result.count("bound") == 0);
+  CHECK(result["bound"].as<int>() == 9);
+  CHECK(bound == 9);
+  CHECK(result.get(depth) == 1);
+  CHECK(result.count(depth) == 0);
+  CHECK(result["option42"].as<int>() == 42);
+  CHECK(result["option42"].has_default());
+  CHECK((result["files"].as<std::vector<std::string>>() ==
+    std::vector<std::string>{"x", "y"}));
+  CHECK_THROWS_AS(result["name"].as<std::string>(),
+    cxxopts::option_has_no_value_exception&);
+  CHECK_THROWS_AS(result["missing"], cxxopts::option_not_present_exception&);
+
+  bound = 0;
+  Argv given({"sparse", "--bound", "4"});
+  result = options.parse(given.argc(), given.argv());
+  CHECK(bound == 4);
+  CHECK(result["bound"].as<int>() == 4);
+  CHECK_FALSE(result["verbose"].as<bool>());
+  CHECK(result.count("verbose") == 0);
+}
+
+TEST_CASE("Lazy conversion", "[lazy]") {
+  int bound = 0;
+
+  cxxopts::Options options("lazy", " - convert values when they are read");
+  options.set_lazy_conversion();
+  options.add_options()
+    ("n,number", "a number", cxxopts::value<int>())
+    ("l,list", "a list", cxxopts::value<std::vector<int>>()
+      ->implicit_value("0"))
+    ("b,bound", "a bound number", cxxopts::value<int>(bound))
+    ("v,verbose", "verbose output")
+    ;
+
+  SECTION("Values are converted when read") {
+    Argv av({"lazy", "-n", "12", "--list=1,2", "--list", "--list=3", "-v"});
+    auto result = options.parse(av.argc(), av.argv());
+
+    CHECK(result.count("list") == 3);
+    CHECK((result["list"].as<std::vector<int>>() ==
+      std::vector<int>{1, 2, 0, 3}));
+    CHECK(result["number"].as<int>() == 12);
+    CHECK(result["number"].get<int>() == 12);
+    CHECK(result["verbose"].as<bool>());
+  }
+
+  SECTION("Errors are reported when read") {
+    Argv av({"lazy", "-n", "twelve", "-b", "4"});
+    auto result = options.parse(av.argc(), av.argv());
+
+    CHECK(bound == 4);
+    CHECK(result.count("number") == 1);
+    CHECK_THROWS_AS(result["number"].as<int>(),
+      cxxopts::argument_incorrect_type&);
+    CHECK_THROWS_AS(result["number"].as<int>(),
+      cxxopts::argument_incorrect_type&);
+    CHECK_THROWS_AS(result.validate(), cxxopts::argument_incorrect_type&);
+  }
+
+  SECTION("Bound values are converted while parsing") {
+    Argv av({"lazy", "-b", "four"});
+    CHECK_THROWS_AS(options.parse(av.argc(), av.argv()),
+      cxxopts::argument_incorrect_type&);
+  }
+
+  SECTION("Copies and threads share one conversion") {
+    Argv av({"lazy", "--list=5,6,7"});
+    const auto result = options.parse(av.argc(), av.argv());
+    const auto copy = result;
+    result.validate();
+
+    std::vector<const std::vector<int>*> seen(4);
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i != seen.size(); ++i)
+    {
+      readers.emplace_back([&seen, &copy, i] {
+        seen[i] = &copy["list"].as<std::vector<int>>();
+      });
+    }
+    for (auto& reader : readers)
+    {
+      reader.join();
+    }
+
+    CHECK(std::count(seen.begin(), seen.end(), seen[0]) == 4);
+    CHECK(seen[0] == &result["list"].as<std::vector<int>>());
+    CHECK(seen[0]->size() == 3);
+  }
+}
+
+namespace {
+
+// Too large to be stored inside a result's value slot.
+struct Large
+{
+  std::string text{};
+  double padding[8] = {};
+};
+
+std::istream&
+operator>>(std::istream& in, Large& large)
+{
+  return in >> large.text;
+}
+
+// Small enough for a value slot, but its move constructor may throw.
+struct MayThrowOnMove
+{
+  MayThrowOnMove() = default;
+  MayThrowOnMove(const MayThrowOnMove&) = default;
+  MayThrowOnMove& operator=(const MayThrowOnMove&) = default;
+
+  MayThrowOnMove(MayThrowOnMove&& rhs) noexcept(false)
+  : text(std::move(rhs.text))
+  {
+  }
+
+  std::string text{};
+};
+
+std::istream&
+operator>>(std::istream& in, MayThrowOnMove& value)
+{
+  return in >> value.text;
+}
+
+} // namespace
+
+TEST_CASE("Value slots", "[slot]") {
+  std::vector<int> bound{7};
+
+  cxxopts::Options options("slots", " - values stored in results");
+  options.add_options()
+    ("i,int", "an int", cxxopts::value<int>())
+    ("s,string", "a string", cxxopts::value<std::string>())
+    ("large", "a large value", cxxopts::value<Large>())
+    ("b,bound", "a bound list", cxxopts::value<std::vector<int>>(bound))
+    ("throwing", "a value whose move may throw",
+      cxxopts::value<MayThrowOnMove>())
+    ;
+
+  Argv av({"slots", "-i", "3", "-s", "a string too long for small strings",
+    "--large", "big", "-b", "8,9", "--throwing", "moved"});
+  auto result = options.parse(av.argc(), av.argv());
+
+  CHECK((bound == std::vector<int>{7, 8, 9}));
+  CHECK(&result["bound"].as<std::vector<int>>() == &bound);
+
+  const auto copy = result;
+  const auto moved = std::move(result);
+
+  for (const auto* r : {&copy, &moved})
+  {
+    CHECK((*r)["int"].as<int>() == 3);
+    CHECK((*r)["string"].as<std::string>() ==
+      "a string too long for small strings");
+    CHECK((*r)["large"].as<Large>().text == "big");
+    CHECK(&(*r)["bound"].as<std::vector<int>>() == &bound);
+  }
+
+  CHECK(&copy["large"].as<Large>() != &moved["large"].as<Large>());
+
+  // a value that may throw when moved is kept on the heap, so moving its
+  // slot does not move the value
+  static_assert(std::is_nothrow_move_constructible<cxxopts::OptionValue>::value,
+    "moving a value slot cannot throw");
+  cxxopts::OptionValue value = copy["throwing"];
+  const auto* address = &value.as<MayThrowOnMove>();
+  const cxxopts::OptionValue taken(std::move(value));
+  CHECK(&taken.as<MayThrowOnMove>() == address);
+  CHECK(taken.as<MayThrowOnMove>().text == "moved");
+  CHECK_THROWS_AS(copy["int"].as<long>(), cxxopts::invalid_option_type_error&);
+  CHECK_THROWS_AS(copy["string"].get<int>(),
+    cxxopts::invalid_option_type_error&);
+}
+
+TEST_CASE("Parse with a callback", "[callback]") {
+  cxxopts::Options options("callback", " - test callback parsing");
+  options.add_options()
+    ("a,av", "a string", cxxopts::value<std::string>())
+    ("n,number", "a number", cxxopts::value<int>()->default_value("7"))
+    ("v,verbose", "verbose")
+    ("l,level", "a level", cxxopts::value<int>()->implicit_value("3"))
+    ("input", "input", cxxopts::value<std::string>())
+    ("rest", "rest", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional({"input", "rest"});
+
+  using Kind = cxxopts::ParseEvent::Kind;
+  std::vector<std::string> seen;
+  auto record = [&](const cxxopts::ParseEvent& event) {
+    std::string s;
+    switch (event.kind())
+    {
+      case Kind::Option: s = "option "; break;
+      case Kind::Positional: s = "positional "; break;
+      case Kind::Unmatched: s = "unmatched "; break;
+      case Kind::EndOfOptions: s = "end "; break;
+    }
+    if (event.option() != nullptr)
+    {
+      s += event.option()->long_name() + " " + event.name().str() + "=";
+    }
+    s += event.value().str();
+    if (event.implicit())
+    {
+      s += " (implicit)";
+    }
+    seen.push_back(s);
+  };
+
+  SECTION("Events are in argument order") {
+    Argv av({"callback", "-vn", "12", "in", "--av=x", "-l", "--level=5",
+      "r1", "--", "-r2"});
+    options.parse(av.argc(), av.argv(), record);
+
+    const std::vector<std::string> expected = {
+      "option verbose v=true (implicit)",
+      "option number n=12",
+      "positional input input=in",
+      "option av av=x",
+      "option level l=3 (implicit)",
+      "option level level=5",
+      "positional rest rest=r1",
+      "end --",
+      "positional rest rest=-r2",
+    };
+    CHECK(seen == expected);
+  }
+
+  SECTION("Options given by name are not filled from positionals") {
+    Argv av({"callback", "--input", "named", "first", "second"});
+    options.parse(av.argc(), av.argv(), record);
+
+    const std::vector<std::string> expected = {
+      "option input input=named",
+      "positional rest rest=first",
+      "positional rest rest=second",
+    };
+    CHECK(seen == expected);
+  }
+
+  SECTION("Typed values") {
+    Argv av({"callback", "-n", "42", "--level"});
+    int number = 0;
+    int level = 0;
+    options.parse(av.argc(), av.argv(), [&](const cxxopts::ParseEvent& e) {
+      if (e.option()->long_name() == "number")
+      {
+        number = e.as<int>();
+      }
+      else
+      {
+        level = e.as<int>();
+      }
+    });
+    CHECK(number == 42);
+    CHECK(level == 3);
+  }
+
+  SECTION("Unrecognised arguments") {
+    cxxopts::Options loose("loose", " - unrecognised options");
+    loose.add_options()("x", "an x");
+    loose.allow_unrecognised_options();
+
+    Argv av({"loose", "--what", "-x", "free", "-#"});
+    loose.parse(av.argc(), av.argv(), record);
+
+    const std::vector<std::string> expected = {
+      "unmatched --what",
+      "option  x=true (implicit)",
+      "unmatched free",
+      "unmatched -#",
+    };
+    CHECK(seen == expected);
+  }
+
+  SECTION("Errors match parse") {
+    Argv missing({"callback", "--av"});
+    CHECK_THROWS_AS(options.parse(missing.argc(), missing.argv(), record),
+      cxxopts::missing_argument_exception&);
+    CHECK_THROWS_AS(options.parse(missing.argc(), missing.argv()),
+      cxxopts::missing_argument_exception&);
+
+    Argv unknown({"callback", "--nope"});
+    CHECK_THROWS_AS(options.parse(unknown.argc(), unknown.argv(), record),
+      cxxopts::option_not_exists_exception&);
+
+    Argv syntax({"callback", "-#"});
+    CHECK_THROWS_AS(options.parse(syntax.argc(), syntax.argv(), record),
+      cxxopts::option_syntax_exception&);
+  }
+}
+
+TEST_CASE("Parse event iterator", "[events]") {
+  cxxopts::Options options("events", " - test parse events");
+  options.add_options()
+    ("a,av", "a string", cxxopts::value<std::string>())
+    ("v,verbose", "verbose")
+    ("command", "command", cxxopts::value<std::string>())
+    ;
+  options.parse_positional({"command"});
+
+  using Kind = cxxopts::ParseEvent::Kind;
+
+  SECTION("Events are in argument order") {
+    Argv av({"events", "-vva", "x", "run", "extra"});
+    auto events = options.events(av.argc(), av.argv());
+
+    std::vector<std::string> seen;
+    for (const auto& event : events)
+    {
+      std::string s = event.name().str() + "=" + event.value().str();
+      if (event.kind() == Kind::Unmatched)
+      {
+        s = "unmatched " + s;
+      }
+      seen.push_back(s);
+    }
+
+    const std::vector<std::string> expected = {
+      "v=true",
+      "v=true",
+      "a=x",
+      "command=run",
+      "unmatched =extra",
+    };
+    CHECK(seen == expected);
+  }
+
+  SECTION("Stopping at a subcommand") {
+    Argv av({"events", "-v", "run", "--only-for-run", "-#"});
+    auto events = options.events(av.argc(), av.argv());
+
+    int index = 0;
+    for (auto it = events.begin(); it != events.end(); ++it)
+    {
+      if (it->kind() == Kind::Positional)
+      {
+        CHECK(it->value() == "run");
+        index = events.argument_index();
+        break;
+      }
+    }
+
+    CHECK(index == 2);
+  }
+
+  SECTION("Errors are thrown as the events are read") {
+    Argv av({"events", "-v", "--nope"});
+    auto events = options.events(av.argc(), av.argv());
+
+    auto it = events.begin();
+    REQUIRE(it != events.end());
+    CHECK(it->option()->long_name() == "verbose");
+    CHECK_THROWS_AS(++it, cxxopts::option_not_exists_exception&);
+
+    Argv missing({"events", "-a"});
+    auto unfinished = options.events(missing.argc(), missing.argv());
+    CHECK_THROWS_AS(unfinished.begin(),
+      cxxopts::missing_argument_exception&);
+  }
+
+  SECTION("No arguments") {
+    Argv av({"events"});
+    auto events = options.events(av.argc(), av.argv());
+    CHECK(events.begin() == events.end());
+  }
+}
+
+TEST_CASE("Incremental parser", "[incremental]") {
+  cxxopts::Options options("incremental", " - test incremental parsing");
+  options.add_options()
+    ("a,av", "a string", cxxopts::value<std::string>())
+    ("n,number", "a number", cxxopts::value<int>()->default_value("7"))
+    ("v,verbose", "verbose")
+    ("input", "input", cxxopts::value<std::string>())
+    ;
+  options.parse_positional({"input"});
+
+  auto parser = options.incremental();
+
+  SECTION("Arguments need not outlive feed") {
+    for (const char* arg : {"-v", "--av", "value", "in", "extra"})
+    {
+      std::string copy = arg;
+      parser.feed(copy);
+      copy.assign(copy.size(), '?');
+    }
+
+    CHECK(!parser.pending());
+    auto result = parser.finish();
+
+    CHECK(result.count("verbose") == 1);
+    CHECK(result["av"].as<std::string>() == "value");
+    CHECK(result["input"].as<std::string>() == "in");
+    CHECK(result["number"].as<int>() == 7);
+    REQUIRE(result.unmatched().size() == 1);
+    CHECK(result.unmatched()[0] == "extra");
+  }
+
+  SECTION("Pending options") {
+    parser.feed("-n");
+    CHECK(parser.pending());
+    parser.feed("12");
+    CHECK(!parser.pending());
+    CHECK(parser.finish()["number"].as<int>() == 12);
+
+    // the parser starts again after finish
+    parser.feed("-a");
+    CHECK_THROWS_AS(parser.finish(), cxxopts::missing_argument_exception&);
+  }
+
+  SECTION("Same result as parse") {
+    Argv av({"incremental", "-vn3", "--av=x", "positional"});
+    auto whole = options.parse(av.argc(), av.argv());
+
+    for (int i = 1; i < av.argc(); ++i)
+    {
+      parser.feed(av.argv()[i]);
+    }
+    auto result = parser.finish();
+
+    REQUIRE(result.arguments().size() == whole.arguments().size());
+    for (std::size_t i = 0; i != result.arguments().size(); ++i)
+    {
+      CHECK(result.arguments()[i].key() == whole.arguments()[i].key());
+      CHECK(result.arguments()[i].value() == whole.arguments()[i].value());
+    }
+    CHECK(result["number"].as<int>() == 3);
+  }
+
+  SECTION("Reset") {
+    CHECK_THROWS_AS(parser.feed("--nope"),
+      cxxopts::option_not_exists_exception&);
+    parser.reset();
+    parser.feed("-a");
+    parser.reset();
+    CHECK(!parser.pending());
+    parser.feed("-v");
+    CHECK(parser.finish().count("verbose") == 1);
+  }
+}
+
+TEST_CASE("Parse context", "[context]") {
+  cxxopts::Options options("context", " - test parse contexts");
+  options.add_options()
+    ("a,av", "a string", cxxopts::value<std::string>())
+    ("n,number", "a number", cxxopts::value<int>()->default_value("7"))
+    ("v,verbose", "verbose")
+    ("list", "a list", cxxopts::value<std::vector<int>>())
+    ;
+
+  auto context = options.context();
+
+  Argv first({"context", "-v", "--av", "a long string value", "--list=1,2",
+    "free"});
+  Argv second({"context", "--list=3", "-n", "9"});
+
+  const auto& a = context.parse(first.argc(), first.argv());
+  CHECK(a.count("verbose") == 1);
+  CHECK(a["av"].as<std::string>() == "a long string value");
+  CHECK(a["number"].as<int>() == 7);
+  CHECK(a["list"].as<std::vector<int>>() == std::vector<int>({1, 2}));
+  CHECK(a.unmatched() == std::vector<std::string>({"free"}));
+
+  // the same result, now holding only the second parse
+  const auto& b = context.parse(second.argc(), second.argv());
+  CHECK(&a == &b);
+  CHECK(b.count("verbose") == 0);
+  CHECK(b.count("av") == 0);
+  CHECK_THROWS_AS(b["av"].as<std::string>(),
+    cxxopts::option_has_no_value_exception&);
+  CHECK(b["number"].as<int>() == 9);
+  CHECK(b["list"].as<std::vector<int>>() == std::vector<int>({3}));
+  CHECK(b.unmatched().empty());
+  REQUIRE(b.arguments().size() == 2);
+  CHECK(b.arguments()[0].key() == "list");
+  CHECK(b.arguments()[1].value() == "9");
+
+  // a copy is not changed by later parses
+  auto copy = context.parse(first.argc(), first.argv());
+  context.parse(second.argc(), second.argv());
+  CHECK(copy["av"].as<std::string>() == "a long string value");
+
+  Argv bad({"context", "--nope"});
+  CHECK_THROWS_AS(context.parse(bad.argc(), bad.argv()),
+    cxxopts::option_not_exists_exception&);
+  CHECK(context.parse(first.argc(), first.argv())["number"].as<int>() == 7);
+
+  context.reset();
+  CHECK(context.result().arguments().empty());
+}
+
+TEST_CASE("Parse a batch", "[batch]") {
+  cxxopts::Options options("batch", " - test batch parsing");
+  options.add_options()
+    ("n,number", "a number", cxxopts::value<int>())
+    ("v,verbose", "verbose")
+    ;
+
+  std::vector<std::vector<std::string>> texts;
+  for (int i = 0; i != 1000; ++i)
+  {
+    if (i % 100 == 7)
+    {
+      texts.push_back({"batch", "--nope"});
+    }
+    else
+    {
+      texts.push_back({"batch", "-n", std::to_string(i), "-v"});
+    }
+  }
+
+  std::vector<std::vector<const char*>> argvs;
+  std::vector<cxxopts::CommandLine> lines;
+  for (const auto& text : texts)
+  {
+    std::vector<const char*> argv;
+    for (const auto& argument : text)
+    {
+      argv.push_back(argument.c_str());
+    }
+    argvs.push_back(std::move(argv));
+  }
+  for (const auto& argv : argvs)
+  {
+    lines.push_back({static_cast<int>(argv.size()), argv.data()});
+  }
+
+  for (unsigned workers : {1u, 4u, 0u})
+  {
+    auto results = options.parse_batch(lines, workers);
+    REQUIRE(results.size() == lines.size());
+
+    for (int i = 0; i != 1000; ++i)
+    {
+      const auto& item = results[static_cast<std::size_t>(i)];
+      if (i % 100 == 7)
+      {
+        REQUIRE(item.error != nullptr);
+        CHECK_THROWS_AS(std::rethrow_exception(item.error),
+          cxxopts::option_not_exists_exception&);
+      }
+      else
+      {
+        REQUIRE(item.error == nullptr);
+        CHECK(item.result["number"].as<int>() == i);
+        CHECK(item.result.count("verbose") == 1);
+      }
+    }
+  }
+
+  CHECK(options.parse_batch({}).empty());
+}
+
+TEST_CASE("Validate without parsing", "[validate]") {
+  int bound = 5;
+  cxxopts::Options options("validate", " - test validation");
+  options.add_options()
+    ("n,number", "a number", cxxopts::value<int>())
+    ("b,bound", "a bound number", cxxopts::value<int>(bound))
+    ("v,verbose", "verbose")
+    ("input", "input", cxxopts::value<int>())
+    ;
+  options.parse_positional({"input"});
+
+  using Error = cxxopts::ParseError;
+
+  Argv good({"validate", "-vn", "3", "--bound=9", "12", "extra"});
+  auto ok = options.validate(good.argc(), good.argv());
+  CHECK(ok);
+  CHECK(ok.error() == Error::None);
+  CHECK(ok.index() == 0);
+  CHECK(bound == 5);
+
+  Argv type({"validate", "-v", "--bound", "nine"});
+  auto bad_type = options.validate(type.argc(), type.argv());
+  CHECK(!bad_type);
+  CHECK(bad_type.error() == Error::IncorrectType);
+  CHECK(bad_type.index() == 3);
+
+  Argv positional({"validate", "-n", "1", "x"});
+  auto bad_positional = options.validate(positional.argc(), positional.argv());
+  CHECK(bad_positional.error() == Error::IncorrectType);
+  CHECK(bad_positional.index() == 3);
+
+  Argv unknown({"validate", "-v", "-vq", "--nope"});
+  auto bad_name = options.validate(unknown.argc(), unknown.argv());
+  CHECK(bad_name.error() == Error::UnknownOption);
+  CHECK(bad_name.index() == 2);
+
+  Argv syntax({"validate", "-#"});
+  CHECK(options.validate(syntax.argc(), syntax.argv()).error() ==
+    Error::Syntax);
+
+  Argv missing({"validate", "-v", "--number"});
+  auto bad_missing = options.validate(missing.argc(), missing.argv());
+  CHECK(bad_missing.error() == Error::MissingArgument);
+  CHECK(bad_missing.index() == 2);
+
+  // parse still throws the same errors
+  CHECK_THROWS_AS(options.parse(unknown.argc(), unknown.argv()),
+    cxxopts::option_not_exists_exception&);
+  CHECK_THROWS_AS(options.parse(missing.argc(), missing.argv()),
+    cxxopts::missing_argument_exception&);
+}
+
+TEST_CASE("Parse cache", "[cache]") {
+  cxxopts::Options options("cache", " - test the parse cache");
+  options.add_options()
+    ("n,number", "a number", cxxopts::value<int>())
+    ("v,verbose", "verbose")
+    ;
+
+  cxxopts::ParseCache cache(options.compiled(), 2);
+  CHECK(cache.capacity() == 2);
+
+  Argv one({"cache", "-n", "1"});
+  Argv one_again({"other-name", "-n", "1"});
+  Argv two({"cache", "-n", "2"});
+  Argv three({"cache", "-n", "3"});
+  // the same bytes, split into different arguments
+  Argv joined({"cache", "-n1"});
+  Argv split({"cache", "-n", "1", ""});
+
+  auto first = cache.parse(one.argc(), one.argv());
+  CHECK((*first)["number"].as<int>() == 1);
+  CHECK(cache.misses() == 1);
+
+  auto second = cache.parse(one_again.argc(), one_again.argv());
+  CHECK(second == first);
+  CHECK(cache.hits() == 1);
+
+  CHECK(cache.parse(joined.argc(), joined.argv()) != first);
+  CHECK(cache.parse(split.argc(), split.argv()) != first);
+  CHECK(cache.misses() == 3);
+  CHECK(cache.size() == 2);
+
+  // the least recently used results are dropped
+  cache.parse(two.argc(), two.argv());
+  cache.parse(three.argc(), three.argv());
+  CHECK(cache.size() == 2);
+  auto again = cache.parse(one.argc(), one.argv());
+  CHECK(again != first);
+  CHECK((*again)["number"].as<int>() == 1);
+  CHECK(cache.parse(three.argc(), three.argv())->count("number") == 1);
+  CHECK(cache.hits() == 2);
+  CHECK(cache.misses() == 6);
+
+  Argv bad({"cache", "--nope"});
+  CHECK_THROWS_AS(cache.parse(bad.argc(), bad.argv()),
+    cxxopts::option_not_exists_exception&);
+  CHECK(cache.misses() == 7);
+
+  cache.clear();
+  CHECK(cache.size() == 0);
+  CHECK(cache.hits() == 0);
+
+  cxxopts::ParseCache none(options.compiled(), 0);
+  none.parse(one.argc(), one.argv());
+  none.parse(one.argc(), one.argv());
+  CHECK(none.hits() == 0);
+  CHECK(none.size() == 0);
+}
+
+TEST_CASE("Command strings", "[command]") {
+  auto split = [](const char* command) {
+    cxxopts::CommandString arguments(command);
+    return std::vector<std::string>(arguments.argv(),
+      arguments.argv() + arguments.argc());
+  };
+
+  using Words = std::vector<std::string>;
+
+  CHECK(split("") == Words{});
+  CHECK(split(" \t\n ") == Words{});
+  CHECK(split("prog -a  --bee=c\td") == Words({"prog", "-a", "--bee=c", "d"}));
+  CHECK(split("prog 'a b' \"c d\"") == Words({"prog", "a b", "c d"}));
+  CHECK(split("prog '' \"\" x") == Words({"prog", "", "", "x"}));
+  CHECK(split("prog a'b c'd\"e\"") == Words({"prog", "ab cde"}));
+  CHECK(split("prog '\\n \"x\"'") == Words({"prog", "\\n \"x\""}));
+  CHECK(split("prog \"\\$ \\` \\\" \\\\ \\a\"") ==
+    Words({"prog", "$ ` \" \\ \\a"}));
+  CHECK(split("prog a\\ b \\'c") == Words({"prog", "a b", "'c"}));
+  CHECK(split("prog ab\\\ncd \"x\\\ny\"") == Words({"prog", "abcd", "xy"}));
+
+  CHECK_THROWS_AS(split("prog 'open"), cxxopts::command_syntax_exception&);
+  CHECK_THROWS_AS(split("prog \"open\\\""),
+    cxxopts::command_syntax_exception&);
+  CHECK_THROWS_AS(split("prog end\\"), cxxopts::command_syntax_exception&);
+
+  // a command that cannot be split still leaves terminated words
+  std::vector<char> buffer;
+  std::vector<const char*> partial;
+  for (const char* command : {"prog abcdefgh\\", "prog \"abcdefgh"})
+  {
+    CHECK_FALSE(cxxopts::values::parser_tool::SplitCommand(command, buffer,
+      partial));
+    REQUIRE(partial.size() == 2);
+    const auto offset = static_cast<std::size_t>(partial[1] - buffer.data());
+    REQUIRE(offset + std::strlen("abcdefgh") < buffer.size());
+    CHECK(std::string(partial[1]) == "abcdefgh");
+  }
+
+  // argv stays valid when the arguments are moved
+  cxxopts::CommandString small("a b");
+  cxxopts::CommandString moved(std::move(small));
+  REQUIRE(moved.argc() == 2);
+  CHECK(std::string(moved.argv()[1]) == "b");
+
+  cxxopts::Options options("command", " - test command strings");
+  options.add_options()
+    ("n,name", "a name", cxxopts::value<std::string>())
+    ("v,verbose", "verbose")
+    ("rest", "rest", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional({"rest"});
+
+  auto result = options.parse("command -v --name 'two words' \"x y\" z");
+  CHECK(result.count("verbose") == 1);
+  CHECK(result["name"].as<std::string>() == "two words");
+  CHECK(result["rest"].as<std::vector<std::string>>() ==
+    Words({"x y", "z"}));
+}
+
+TEST_CASE("Corpus analysis", "[corpus]") {
+  cxxopts::Options options("corpus", " - test corpus analysis");
+  options.add_options()
+    ("v,verbose", "verbose")
+    ("o,output", "output", cxxopts::value<std::string>())
+    ("j,jobs", "jobs", cxxopts::value<int>())
+    ("rest", "rest", cxxopts::value<std::vector<std::string>>())
+    ;
+  options.parse_positional({"rest"});
+
+  const auto schema = options.compiled();
+  auto id = [&](const std::string& name) {
+    for (std::size_t i = 0; i != schema->option_count(); ++i)
+    {
+      if (schema->option(i) != nullptr && schema->option(i)->long_name() == name)
+      {
+        return i;
+      }
+    }
+    FAIL("no option " << name);
+    return std::size_t{0};
+  };
+
+  using Error = cxxopts::ParseError;
+  auto errors = [](const cxxopts::CorpusStats& stats, Error kind) {
+    return stats.errors[static_cast<std::size_t>(kind)];
+  };
+
+  std::string shell =
+    "cc -v -o 'a b' x\n"
+    "\n"
+    "cc --jobs 4 -o c y z\r\n"
+    "cc -j four\n"
+    "cc --bogus\n"
+    "cc -o\n"
+    "cc 'open\n"
+    "cc -v -o 'a b'";
+
+  auto stats = options.analyse_corpus(shell, cxxopts::CorpusFormat::Shell);
+  CHECK(stats.commands == 7);
+  CHECK(stats.error_count() == 4);
+  CHECK(errors(stats, Error::IncorrectType) == 1);
+  CHECK(errors(stats, Error::UnknownOption) == 1);
+  CHECK(errors(stats, Error::MissingArgument) == 1);
+  CHECK(errors(stats, Error::Quoting) == 1);
+  CHECK(stats.errors.size() == static_cast<std::size_t>(Error::Count));
+  CHECK(std::string(cxxopts::parse_error_name(Error::Quoting)) == "quoting");
+  CHECK(stats.unmatched == 0);
+  CHECK(stats.uses[id("verbose")] == 2);
+  CHECK(stats.values[id("verbose")].empty());
+  CHECK(stats.uses[id("output")] == 3);
+  CHECK(stats.values[id("output")].at("a b") == 2);
+  CHECK(stats.values[id("output")].at("c") == 1);
+  CHECK(stats.uses[id("jobs")] == 1);
+  CHECK(stats.uses[id("rest")] == 3);
+  CHECK(stats.values[id("rest")].at("y") == 1);
+
+  // values beyond the cap are only counted
+  stats = options.analyse_corpus(shell, cxxopts::CorpusFormat::Shell, 1, 1);
+  CHECK(stats.values[id("output")].size() == 1);
+  CHECK(stats.other_values[id("output")] == 1);
+
+  // a line that cannot be split is an error, and none of its words are used
+  stats = options.analyse_corpus("prog abcdefgh\\\nprog \"abcdefgh",
+    cxxopts::CorpusFormat::Shell);
+  CHECK(stats.commands == 2);
+  CHECK(errors(stats, Error::Quoting) == 2);
+  CHECK(stats.error_count() == 2);
+  CHECK(stats.uses[id("rest")] == 0);
+
+  const char lines_with_nul[] = "cc\0-v\0--output=a b\0x\0\ncc\0-j\0four\0\n"
+    "cc\0-o";
+  const std::string cmdline(lines_with_nul, sizeof(lines_with_nul) - 1);
+  stats = options.analyse_corpus(cmdline, cxxopts::CorpusFormat::Cmdline);
+  CHECK(stats.commands == 3);
+  CHECK(errors(stats, Error::IncorrectType) == 1);
+  CHECK(errors(stats, Error::MissingArgument) == 1);
+  CHECK(stats.values[id("output")].at("a b") == 1);
+  CHECK(stats.values[id("rest")].at("x") == 1);
+
+  // a corpus of several chunks, where lines cross the chunk boundaries
+  std::string large;
+  std::size_t lines = 0;
+  while (large.size() < (std::size_t{3} << 20))
+  {
+    large += "cc -j " + std::to_string(lines % 7) + " -o out" +
+      std::to_string(lines % 13) + ".o in.c\n";
+    ++lines;
+  }
+
+  const auto one = options.analyse_corpus(large,
+    cxxopts::CorpusFormat::Shell, 1);
+  const auto three = options.analyse_corpus(large,
+    cxxopts::CorpusFormat::Shell, 3);
+  CHECK(one.commands == lines);
+  CHECK(three.commands == lines);
+  CHECK(three.error_count() == 0);
+  CHECK(three.uses == one.uses);
+  CHECK(three.values == one.values);
+  CHECK(three.values[id("jobs")].size() == 7);
+  CHECK(three.values[id("output")].size() == 13);
+}